@@ -0,0 +1,34 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "sim.hpp"
+#include "snapshot.hpp"
+
+// Ukládání na pozadí. Hlavní vlákno zaplatí jen snapshot_take() (nezměněné
+// bloky mapy se sdílí s minulým snapshotem); obnovu do pracovní kopie,
+// save_encode() a atomický zápis (dočasný soubor, fsync, rename) dělá vlákno.
+// S 'delta' se do souboru píše delta proti keyframe (save_game_chain()).
+struct SaveResult{ std::string path; int tag=0; bool ok=false; double ms=0; size_t chunks=0; };
+
+struct AsyncSaver{
+    struct Job{ std::shared_ptr<const SimSnapshot> snap; std::vector<UnitType> types; std::string path; int tag; bool delta; };
+    SimSnapshot last;            // jen hlavní vlákno: bloky mapy minulého snapshotu (state se nepoužívá)
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::deque<SaveResult> done;
+    bool busy=false, quit=false;
+    std::thread worker;
+    AsyncSaver();
+    ~AsyncSaver();               // dokončí rozpracované savy
+};
+
+// Pořídí snapshot na hranici ticku a zařadí zápis do 'path'; 'tag' se vrátí v SaveResult.
+bool async_save_request(AsyncSaver& a, const Sim& s, const std::string& path, int tag=0, bool delta=false);
+bool async_save_poll(AsyncSaver& a, SaveResult& out); // hotové savy (neblokuje)
+void async_save_wait(AsyncSaver& a);                  // počká na frontu (ukončení hry)
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include "types.hpp"
+struct Sim;
+
+// Procenta poškození podle typu útoku (řádek) a brnění (sloupec).
+constexpr uint8_t kDamagePct[4][4] = {
+    //            Light Medium Heavy Building
+    /* Normal */ { 100,  150,  100,   70 },
+    /* Pierce */ { 200,   75,  100,   35 },
+    /* Siege  */ { 100,   50,  100,  150 },
+    /* Magic  */ { 125,   75,  200,   35 },
+};
+
+// Poškození jednoho zásahu (celočíselně, deterministicky), minimálně 1.
+inline int combat_damage(const Attack& a, const Armor& ar){
+    int d = (int)a.damage * kDamagePct[(int)a.type][(int)ar.type] / 100 - ar.value;
+    return d < 1 ? 1 : d;
+}
+
+// Akvizice cílů / přepočet cesty jen každý N-tý tick (rozloženo podle id).
+constexpr uint32_t kAcquireEvery = 4;
+
+void order_attack(Sim& s, UnitId u, UnitId target);
+
+// Jeden tick boje (jen bdělé jednotky): cooldowny, akvizice cílů přes unit_grid,
+// pohyb k cíli, zásahy do Sim::dmg_buf a pak jedno dávkové uplatnění
+// (zasažené spící jednotky se probudí) + odstranění mrtvých.
+void combat_step(Sim& s, uint32_t dt_ms);
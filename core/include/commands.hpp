@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.hpp"
+struct Sim;
+
+// Hráčský příkaz – jediná cesta, kterou frontend mění simulaci.
+// Pole podle typu:
+//   Move / Gather      unit, x, y
+//   Build              unit, arg = BuildingId
+//   Attack             unit, arg = cílová UnitId
+//   PlaceBuilding      x, y, arg = BuildingKind
+//   Train              arg = BuildingId, x = unit_type index, y = počet
+//   CancelLastTrain    arg = BuildingId
+//   CancelTrainAt      arg = BuildingId, x = pozice ve frontě
+//   RemoveBuilding     arg = BuildingId
+//   SetRally           arg = BuildingId, x, y
+// 'player' vydává příkaz: jednotky a budovy musí být jeho, PlaceBuilding platí on.
+enum class CmdType : uint8_t {
+    Move=0, Gather=1, Build=2, Attack=3, PlaceBuilding=4,
+    Train=5, CancelLastTrain=6, CancelTrainAt=7, RemoveBuilding=8, SetRally=9
+};
+
+struct Command{
+    uint32_t tick=0; // Sim::tick, před kterým se příkaz provede
+    CmdType type=CmdType::Move;
+    UnitId unit=0;
+    int32_t x=0, y=0;
+    uint32_t arg=0;
+    uint8_t player=0;
+};
+
+// Záznam hry od počátečního stavu load_data + init_resources_from_tiles.
+struct CommandLog{
+    std::string assets = "assets";
+    int wood_amount=300, gold_amount=500; // init_resources_from_tiles (jen u map.txt)
+    int players=1;         // set_player_count() před prvním příkazem (starší záznamy = 1)
+    std::vector<Command> cmds;
+    uint32_t end_tick=0;   // délka záznamu (0 = neznámá)
+    uint64_t end_hash=0;   // state_hash() v end_tick (0 = neověřovat)
+};
+
+// Provede příkaz nad 's'; u PlaceBuilding vrátí nové BuildingId, jinak 1/0 (úspěch).
+uint32_t apply_command(Sim& s, const Command& c);
+
+// Provede a (je-li log) zaznamená s aktuálním tickem.
+uint32_t submit_command(Sim& s, CommandLog* log, Command c);
+
+bool save_command_log(const CommandLog& log, const std::string& path);
+bool load_command_log(CommandLog& log, const std::string& path);
+
+// Přehraje záznam bez vykreslování co nejrychleji. Vrací false při chybě
+// načtení nebo neshodě end_hash.
+bool replay_run(Sim& s, const CommandLog& log, uint32_t dt_ms);
@@ -1,11 +1,34 @@
-
 #pragma once
 #include <string>
 #include <cstdint>
 #include <vector>
-#include <unordered_map>
-struct UnitType; struct Map;
+#include "types.hpp"
+struct Map; struct Vec2i; struct NameIndex;
+// Sloupce podle hlavičky; chybný řádek se vypíše na stderr (soubor:řádek) a přeskočí.
+// false jen když soubor nejde otevřít nebo hlavičce chybí povinný sloupec.
+// 'index' se přestaví nad všemi id v 'out' (perfektní hash, viz name_index.hpp).
 bool load_units_csv(const std::string& path,
                     std::vector<UnitType>& out,
-                    std::unordered_map<std::string,uint16_t>& index);
+                    NameIndex& index);
+// Sloupce id,w,h,cost_gold,cost_wood,build_ms,food_cap_bonus; řádek přepíše typ se stejným
+// id v 'out'. Chybějící soubor = false bez hlášky ('out' zůstane beze změny).
+bool load_buildings_csv(const std::string& path, std::array<BuildingType, kBuildingKinds>& out);
 bool load_map_txt(const std::string& path, Map& out);
+bool save_map_txt(const Map& m, const std::string& path); // stejná abeceda: . # G T D
+
+// Kompilovaná mapa (.rtsmap, little-endian):
+//   hlavička   "RTSM" u32 version, i32 w, i32 h, u32 velikost dat, u32 CRC32 dat,
+//              zdrojový map.txt: u64 velikost, i64 čas změny, u32 CRC32 (vše 0 = bez zdroje, např. --gen)
+//   DROP       u32 n, n x (i32 x, i32 y)              – sklady (dlaždice 4)
+//   RSRC       u32 n, n x (u8 tile, u8 kind, i32 amount) – suroviny podle dlaždice
+//   TILE       u32 n, n x (u8 tile, varint délka)      – RLE po řádcích
+// Průchodnost se nepřenáší – Map::walk dopočítá map_touch_all() stejně rychle.
+constexpr uint32_t kMapBinVersion = 3;
+struct MapSource{ uint64_t size=0; int64_t mtime=0; uint32_t crc=0; };
+bool map_source_of(const std::string& path, MapSource* out); // stat + CRC32 celého souboru (rts_mapc)
+bool save_map_bin(const Map& m, const std::string& path, int wood_amount, int gold_amount, const MapSource& source=MapSource{});
+// Naplní dlaždice, blocked (0), vrstvy surovin a 'dropoffs'; verze/walk nechá na map_touch_all().
+// Se 'source_path' odmítne mapu zastaralou proti zdroji: jiná velikost = zastaralá,
+// stejná velikost i čas = aktuální bez čtení zdroje, jinak (checkout, kopie)
+// rozhodne CRC32 zdroje. Chybějící zdroj se nekontroluje.
+bool load_map_bin(const std::string& path, Map& out, std::vector<Vec2i>& dropoffs, const std::string* source_path=nullptr);
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+struct Vec2i;
+
+// Viditelnost jednoho hráče. 'count' je počet jednotek, které dlaždici vidí;
+// bitsety se mění jen při přechodu 0 <-> 1, takže dotazy jsou jen čtení bitu.
+struct FogLayer{
+    int w=0, h=0, words_per_row=0;
+    std::vector<uint16_t> count;
+    std::vector<uint64_t> visible;  // právě viděno
+    std::vector<uint64_t> explored; // někdy viděno
+};
+
+// Předpočítané razítko kruhu dohledu pro jeden poloměr: celý kruh a pro každý
+// z 8 směrů kroku rozdíl starý/nový kruh (leave relativně ke staré pozici,
+// enter relativně k nové), takže krok o 1 dlaždici sahá jen na okraj kruhu.
+struct DiscStamp{
+    struct Off{ int16_t dx, dy; };
+    std::vector<Off> disc;
+    std::vector<Off> leave[8], enter[8];
+};
+
+struct Fog{
+    int w=0, h=0;
+    std::vector<FogLayer> players; // index = Unit::owner, alokuje se líně
+    std::vector<DiscStamp> stamps; // index = poloměr
+};
+
+void fog_init(Fog& f, int w, int h);
+void fog_add_unit(Fog& f, int player, Vec2i t, int radius);
+void fog_remove_unit(Fog& f, int player, Vec2i t, int radius);
+void fog_move_unit(Fog& f, int player, Vec2i from, Vec2i to, int radius);
+void fog_clear_visible(Fog& f); // vynuluje viditelnost (explored zůstává), pro přestavbu
+
+bool fog_visible(const Fog& f, int player, int x, int y);
+bool fog_explored(const Fog& f, int player, int x, int y);
@@ -1,7 +1,8 @@
-
 #pragma once
 #include <cstdint>
 #include <cmath>
+// Pevná řádová čárka Q16.16 pro simulaci (lockstep / replay): žádné float/double
+// v kódu, který mění stav. from_float/to_float jen pro UI a ladění.
 struct fx{ int32_t v; constexpr fx():v(0){} explicit constexpr fx(int32_t r):v(r){} 
 static fx from_float(float f){ return fx{ (int32_t)llroundf(f*65536.0f)}; } 
 float to_float() const { return (float)v/65536.0f; } };
@@ -9,5 +10,65 @@ inline fx operator+(fx a, fx b){ return fx{a.v+b.v}; }
 inline fx operator-(fx a, fx b){ return fx{a.v-b.v}; }
 inline fx operator*(fx a, fx b){ return fx{ (int32_t)(((int64_t)a.v*(int64_t)b.v)>>16)}; }
 inline fx operator/(fx a, fx b){ return fx{ (int32_t)(((int64_t)a.v<<16)/(int64_t)b.v)}; }
-inline fx fx_from_int(int i){ return fx{i<<16}; }
+inline bool operator<(fx a, fx b){ return a.v<b.v; }
+inline bool operator==(fx a, fx b){ return a.v==b.v; }
+inline constexpr fx fx_from_int(int i){ return fx{i*65536}; }
+inline constexpr fx fx_ratio(int num, int den){ return fx{ (int32_t)(((int64_t)num<<16)/den) }; } // konstanty bez floatu: 3/4
 inline int fx_floor_to_int(fx a){ return a.v>>16; }
+inline int fx_round_to_int(fx a){ return (int)(((int64_t)a.v + 0x8000)>>16); }
+
+// saturace místo přetečení (přetečení int32 je UB a mezi buildy se liší)
+inline int32_t fx_clamp64(int64_t x){ return x>INT32_MAX ? INT32_MAX : x<INT32_MIN ? INT32_MIN : (int32_t)x; }
+inline fx fx_add_sat(fx a, fx b){ return fx{ fx_clamp64((int64_t)a.v + b.v) }; }
+inline fx fx_sub_sat(fx a, fx b){ return fx{ fx_clamp64((int64_t)a.v - b.v) }; }
+inline fx fx_mul_sat(fx a, fx b){ return fx{ fx_clamp64(((int64_t)a.v*(int64_t)b.v) >> 16) }; }
+inline int fx_mul_int_floor(fx a, int i){ return (int)fx_clamp64(((int64_t)a.v * i) >> 16); } // floor(a*i) bez omezení Q16
+inline fx fx_div_sat(fx a, fx b){
+    if(b.v==0) return fx{ a.v<0 ? INT32_MIN : INT32_MAX };
+    return fx{ fx_clamp64(((int64_t)a.v * 65536) / b.v) };
+}
+
+// odmocnina po bitech (celočíselná, stejná na všech platformách); záporné -> 0
+inline fx fx_sqrt(fx a){
+    if(a.v<=0) return fx{0};
+    uint64_t x = (uint64_t)a.v << 16, r = 0, bit = 1ull << 62;
+    while(bit > x) bit >>= 2;
+    while(bit){
+        if(x >= r + bit){ x -= r + bit; r = (r >> 1) + bit; } else r >>= 1;
+        bit >>= 2;
+    }
+    return fx{ (int32_t)r };
+}
+
+// sin/cos z tabulky čtvrtvlny (257 hodnot Q16, lineární interpolace).
+// Úhel je uint16_t v 1/65536 otáčky (16384 = 90°), přetečení = otočení dokola.
+constexpr int32_t kFxSinTable[257] = {
+    0, 402, 804, 1206, 1608, 2010, 2412, 2814, 3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+    6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218, 9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+    12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534, 15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699, 22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+    25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656, 28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+    30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347, 33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716, 39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+    41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713, 44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+    46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288, 48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398, 52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+    54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004, 56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+    57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071, 59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568, 61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+    62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473, 63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+    64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766, 64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436, 65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+    65536,
+};
+inline int32_t fx_sin_quarter(uint32_t p){ // p: 0..16384
+    const uint32_t i = p >> 6, f = p & 63;
+    if(i >= 256) return kFxSinTable[256];
+    return kFxSinTable[i] + (int32_t)(((kFxSinTable[i+1] - kFxSinTable[i]) * (int32_t)f) >> 6);
+}
+inline fx fx_sin(uint16_t angle){
+    const uint32_t q = angle >> 14, p = angle & 0x3FFF;
+    const int32_t v = (q & 1) ? fx_sin_quarter(16384 - p) : fx_sin_quarter(p);
+    return fx{ q >= 2 ? -v : v };
+}
+inline fx fx_cos(uint16_t angle){ return fx_sin((uint16_t)(angle + 16384)); }
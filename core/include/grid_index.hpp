@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mapování (x,y) -> index do pole dlaždic přes dvě tabulky: index = xs[x] + ys[y].
+// Stejný tvar pokryje všechna rozložení:
+//   RowMajor  y*w + x
+//   Block     bloky 8x8 (64 B = jedna cache line pro u8), bloky po řádcích
+//   Morton    dlaždice 16x16 uvnitř v Z-pořadí, dlaždice po řádcích
+// Block/Morton drží svislé sousedy blízko – méně cache miss v A*.
+enum class GridLayout : uint8_t { RowMajor=0, Block=1, Morton=2 };
+
+struct GridIndex{
+    GridLayout layout=GridLayout::RowMajor;
+    int width=0, height=0;
+    size_t size=0; // počet prvků pole včetně zarovnání na bloky
+    std::vector<uint32_t> xs{}, ys{};
+    uint32_t operator()(int x, int y) const { return xs[x] + ys[y]; }
+};
+
+void grid_index_init(GridIndex& g, int w, int h, GridLayout layout);
+const char* grid_layout_name(GridLayout l);
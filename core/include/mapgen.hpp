@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "sim.hpp"
+
+// Deterministický generátor map (RNG podle seedu) pro benchmarky a soak testy.
+// Pořadí: shluky lesa/zlata -> bludiště zdí -> volné okolí skladů.
+// Výchozí parametry dávají stejnou mapu jako dřívější scenario_generate_map().
+constexpr int kMapGenMaxSize = 8192;
+
+struct MapGenParams{
+    int width=256, height=256;
+    uint32_t seed=1;
+    int clump_area=400;      // jeden shluk surovin na tolik dlaždic (0 = žádné)
+    int clump_radius=3;      // poloměr shluku 1..clump_radius
+    int gold_one_in=4;       // shluk je zlatý s pravděpodobností 1/gold_one_in, jinak les
+    int maze_cell=0;         // rozteč zdí bludiště (>= 3), 0 = bez zdí
+    int maze_loops=10;       // % vnitřních zdí odstraněných navíc (smyčky, 0 = dokonalé bludiště)
+    int dropoffs=1;          // sklady v pravidelné mřížce, první uprostřed (u jednoho); k-tý hráči k % players
+    int dropoff_clear=4;     // volný čtverec kolem skladu (poloměr)
+};
+
+// Přepíše s.map (dlaždice, blocked) a Player::dropoffs všech s.players; vrstvy surovin nechá na
+// init_resources_from_tiles(). Rozměry nad kMapGenMaxSize nebo <= 0 = false.
+bool mapgen_generate(Sim& s, const MapGenParams& p);
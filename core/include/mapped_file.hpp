@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Soubor namapovaný jen pro čtení (mmap / CreateFileMapping).
+// Prázdný soubor se otevře s data==nullptr a size==0.
+struct MappedFile{
+    const uint8_t* data=nullptr; size_t size=0;
+    MappedFile()=default;
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+    ~MappedFile();
+#ifdef _WIN32
+    void* file=nullptr; void* mapping=nullptr;
+#else
+    int fd=-1;
+#endif
+};
+
+bool mapped_open(MappedFile& f, const std::string& path);
+void mapped_close(MappedFile& f);
+
+// Velikost a čas poslední změny bez čtení obsahu; čas je nativní pro platformu
+// (POSIX ns od epochy, Windows FILETIME) – porovnávat jen na stejném stroji.
+bool file_stat(const std::string& path, uint64_t* size, int64_t* mtime);
+
+// Zapíše do 'path.tmp', fsync, přejmenuje přes 'path' a fsyncne adresář – při pádu
+// zůstane starý soubor celý, po úspěchu nový přežije i výpadek napájení.
+bool write_file_atomic(const std::string& path, const uint8_t* data, size_t size);
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Perfektní hash (hash & displace) nad pevnou sadou jmen -> index 0..n-1.
+// Staví se jednou při načítání dat; find() = jeden hash řetězce, jedno míchání
+// s posunem koše a jedno porovnání, bez kolizí a bez alokací.
+struct NameIndex{
+    static constexpr uint16_t kNone = UINT16_MAX;
+    uint32_t salt=0;
+    std::vector<uint32_t> seeds;  // posun pro každý koš
+    std::vector<uint16_t> slots;  // slot -> index jména (kNone = volno)
+    std::vector<std::string> names;
+
+    uint16_t find(std::string_view s) const;
+    size_t size() const { return names.size(); }
+};
+
+// names[i] dostane index i; duplicitní jména nebo víc než 65534 = false.
+bool name_index_build(NameIndex& ix, const std::vector<std::string>& names);
@@ -1,5 +1,9 @@
 
 #pragma once
 #include <vector>
+#include <cstdint>
 struct Map; struct Vec2i;
-bool astar_find(const Map& map, Vec2i start, Vec2i goal, std::vector<Vec2i>& out_path, bool diag=false, int max_nodes=8192);
+// occupancy (volitelné): počty jednotek na dlaždici; obsazené dlaždice do vzdálenosti
+// occupancy_radius od startu se berou jako překážka (kromě cíle) – lokální objíždění
+bool astar_find(const Map& map, Vec2i start, Vec2i goal, std::vector<Vec2i>& out_path, bool diag=false, int max_nodes=8192,
+                const std::vector<uint16_t>* occupancy=nullptr, int occupancy_radius=4);
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Lehký profiler s měřením úseků. Bez RTS_PROFILE se makra přeloží na nic.
+//
+//   RTS_PROF_SCOPE("step.units");             // do konce bloku
+//   RTS_PROF_BEGIN(tiles, "frame.tiles"); ... RTS_PROF_END(tiles);
+//
+// Události jdou do kruhového bufferu (pevná kapacita, zápis bez zámku přes
+// atomický index – přepisují se nejstarší) a prof_dump_chrome() je uloží jako
+// Chrome trace_event JSON (chrome://tracing, Perfetto).
+
+uint64_t prof_now_ns();
+void prof_record(const char* name, uint64_t t0_ns, uint64_t t1_ns); // 'name' musí žít navždy (literál)
+bool prof_dump_chrome(const std::string& path); // posledních až kRingSize událostí
+void prof_clear();
+bool prof_enabled(); // true, pokud je rts_core přeložené s RTS_PROFILE
+
+struct ProfSpan{
+    const char* name; uint64_t t0;
+    explicit ProfSpan(const char* n) : name(n), t0(prof_now_ns()) {}
+    void end(){ if(name){ prof_record(name, t0, prof_now_ns()); name = nullptr; } }
+    ~ProfSpan(){ end(); }
+    ProfSpan(const ProfSpan&) = delete; ProfSpan& operator=(const ProfSpan&) = delete;
+};
+
+#define RTS_PROF_CAT2(a,b) a##b
+#define RTS_PROF_CAT(a,b) RTS_PROF_CAT2(a,b)
+#ifdef RTS_PROFILE
+  #define RTS_PROF_SCOPE(name)      ProfSpan RTS_PROF_CAT(prof_scope_, __LINE__)(name)
+  #define RTS_PROF_BEGIN(var, name) ProfSpan prof_span_##var(name)
+  #define RTS_PROF_END(var)         prof_span_##var.end()
+#else
+  #define RTS_PROF_SCOPE(name)      ((void)0)
+  #define RTS_PROF_BEGIN(var, name) ((void)0)
+  #define RTS_PROF_END(var)         ((void)0)
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "sim.hpp"
+
+// Binární save (VERSION 2), little-endian:
+//   hlavička   "RTSB" u32 version, u32 počet sekcí, u32 CRC32 adresáře
+//   adresář    po sekcích: u32 tag (fourcc), u32 CRC32 dat, u64 offset, u64 size
+//   sekce      zarovnané na 8 B; vrstvy mapy jako surová pole (u8 / i32)
+// Neznámé sekce se přeskočí, chybějící povinná sekce nebo špatné CRC = chyba.
+// Hráč 0 je v META/DROP, ostatní hráči a vlastníci budov v nepovinné PLYR
+// (save bez ní = vše patří hráči 0). Cooldown a cíl jednotek jsou v nepovinné
+// UCMB (ve stejném pořadí jako UNIT; bez ní = 0), přesné časování budov v BTIM
+// (bez ní se stavba a výcvik přeplánují od načtení a state_hash se liší).
+// Textový formát VERSION 1 load_game() dál čte (save_game_text() ho zapisuje).
+constexpr uint32_t kSaveVersion = 2;
+
+//
+// Delta save: jen bloky kMapChunk, jejichž verze (Map::chunk_ver) se liší od
+// keyframe, na který odkazuje (sekce BASE: id a jméno souboru ve stejném
+// adresáři), a budovy/jednotky (BDLT/UDLT) celé jen tam, kde se jejich záznam
+// od keyframe liší – ostatní jen id. Delty jsou kumulativní – načtení
+// potřebuje jen keyframe a poslední deltu.
+struct SaveRecords{ std::vector<uint8_t> bytes; std::unordered_map<uint32_t, std::pair<uint32_t,uint32_t>> at; }; // id -> (offset, délka)
+struct SaveKeyframe{ std::string file; uint64_t id=0; int w=0, h=0; std::vector<uint32_t> chunk_ver; SaveRecords units, buildings; };
+void save_keyframe_records(const Sim& s, SaveKeyframe& k); // záznamy entit pro porovnání v deltě (bez nich = všechny změněné)
+
+uint32_t crc32(const uint8_t* p, size_t n); // IEEE (zlib), sdílí i kompilovaná mapa
+
+bool save_is_binary(const uint8_t* data, size_t size);
+void save_encode(const Sim& s, std::vector<uint8_t>& out, uint64_t key_id=0); // key_id != 0: keyframe
+size_t save_encode_delta(const Sim& s, const SaveKeyframe& key, std::vector<uint8_t>& out); // vrací počet bloků
+// Naplní 'ns' (s typy jednotek už nastavenými); indexy/časovače dopočítá volající.
+// 'dir_path' (s koncovým '/') je adresář souboru – u delty se v něm hledá keyframe.
+bool save_decode(Sim& ns, const uint8_t* data, size_t size, const std::string& dir_path="");
+
+// Opakované ukládání do 'path' (autosave): do 'path' jde vždy delta, keyframe se
+// střídavě zapisuje do 'path.k0' / 'path.k1' každých 'keyframe_every' savů, po
+// změně rozměrů mapy a když je změněná víc než polovina bloků. První keyframe
+// nového SaveChain jde do slotu, na který neukazuje delta už ležící v 'path'.
+struct SaveChain{ int keyframe_every=10; int deltas=0; SaveKeyframe key; };
+bool save_game_chain(const Sim& s, SaveChain& c, const std::string& path, size_t* chunks_written=nullptr);
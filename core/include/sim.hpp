@@ -1,11 +1,19 @@
 
 #pragma once
+#include <cassert>
 #include <cstdint>
+#include <array>
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <deque>
+#include <functional>
 #include "types.hpp"
+#include "spatial.hpp"
+#include "fog.hpp"
+#include "timers.hpp"
+#include "grid_index.hpp"
+#include "name_index.hpp"
 
 struct Sim;
 
@@ -13,6 +21,13 @@ struct Vec2i{ int x,y; };
 
 enum class ResourceKind : uint8_t { None=0, Gold=2, Wood=3 };
 
+constexpr int kMapChunk = 32;
+enum MapLayer : uint8_t { kLayerTiles=1, kLayerBlocked=2, kLayerResKind=4, kLayerResAmount=8, kLayerResMax=16, kLayerAll=31 };
+constexpr int kMapLayers = 5; // bit L v MapLayer <-> Map::layer_ver[L]
+
+// Záznam žurnálu změn mapy: dlaždice 'i' a změněné vrstvy (i<0 = celá mapa).
+struct MapChange{ int32_t i; uint8_t layers; };
+
 struct Map {
     int width=0, height=0;
     std::vector<uint8_t> tiles;   // už máš
@@ -22,82 +37,162 @@ struct Map {
     std::vector<uint8_t> res_kind;   // 0=None, 2=Gold, 3=Wood  (kopíruje semantiku tiles)
     std::vector<int>     res_amount; // zůstatek (např. Wood=300, Gold=500)
     std::vector<int>     res_max;
+
+    // verze bloků kMapChunk x kMapChunk dlaždic, viz map_touch():
+    // chunk_ver = poslední změna libovolné vrstvy (snapshoty, delta savy),
+    // layer_ver[L] = poslední změna vrstvy L (cache vykreslení, cest, ...)
+    std::vector<uint32_t> chunk_ver; int chunk_cols=0, chunk_rows=0;
+    std::vector<uint32_t> layer_ver[kMapLayers];
+    std::vector<MapChange> journal; // změny od posledního map_publish(), plní map_touch()/map_touch_all()
+
+    // Cache jen pro A*: průchodnost (tile!=1 && !blocked) v rozložení walk_ix,
+    // udržuje ji map_touch(). Kanonické vrstvy výše zůstávají po řádcích (ridx).
+    GridIndex walk_ix{GridLayout::Morton}; std::vector<uint8_t> walk;
 };
 
-enum class UnitJob:uint8_t{ Idle, Moving, GatheringGold, GatheringWood, Delivering, Building };
+// index do tiles/blocked/res_* (po řádcích) – jediný přepočet (x,y) pro kanonické vrstvy
+static inline int ridx(const Map& m, int x, int y){ return y*m.width + x; }
+
+uint32_t map_next_version();   // globální čítač verzí (unikátní napříč Sim v procesu)
+void map_touch(Map& m, int i, uint8_t layers=kLayerAll); // dlaždice 'i' se změnila -> nová verze bloku + žurnál
+void map_touch_all(Map& m);    // po hromadné změně (načtení, změna rozměrů) -> žurnál {-1}
+void map_set_layout(Map& m, GridLayout l); // rozložení Map::walk (výchozí Morton)
+void map_refresh_walk(Map& m, int x0, int y0, int w, int h); // po přímém zápisu obdélníku (snapshot)
+
+enum class UnitJob:uint8_t{ Idle, Moving, GatheringGold, GatheringWood, Delivering, Building, Attacking };
+enum class WakeReason:uint8_t{ None, Order, Timer, Attacked, Building };
 
 struct Unit{
-    UnitId id; uint16_t type_index;
+    UnitId id; UnitTypeId type_index;
     Vec2i tile; Vec2i goal;
     std::vector<Vec2i> path;
     int hp; uint16_t cooldown;
     bool selected=false;
     UnitJob job=UnitJob::Idle;
+    uint8_t blocked_ticks=0; // kolik ticků čeká na obsazenou dlaždici
     int carried=0; // carried amount
     uint8_t carried_kind=0; // 0 none, 1 gold, 2 wood
     BuildingId building_target=0; // for building
+    uint8_t owner=0;   // hráč / tým (index do Sim::players)
+    UnitId target=0;   // combat target (0 = none)
+    bool asleep=false; uint32_t wake_gen=0; // zaparkovaná: mimo Sim::awake, čeká na wake_unit()
+    WakeReason woke_by=WakeReason::None;
 };
 
-struct TrainItem{ uint16_t unit_type; int remaining_ms; };
+struct TrainItem{ UnitTypeId unit_type; int remaining_ms; };
 
 struct Building{
     BuildingId id; BuildingKind kind; Vec2i tile; // top-left of footprint
     int w=1,h=1;
     BuildState state=BuildState::Planned;
-    int build_progress_ms=0; int build_total_ms=1000;
+    int build_progress_ms=0; int build_total_ms=1000; // progress k build_since_tick, aktuální viz building_progress_ms()
+    int build_workers=0; uint32_t build_since_tick=0; uint32_t build_gen=0; // stavba běží od 'since' touto rychlostí
+    uint32_t train_due_tick=0; uint32_t train_gen=0; // přední položka fronty (TimerKind::TrainDone)
     int cost_gold=0, cost_wood=0;
     std::deque<TrainItem> queue; // production queue (barracks)
     bool selected=false;
     Vec2i rally{ -1, -1 }; 
+    uint8_t owner=0;   // hráč, kterému patří (platí stavbu i výcvik)
 };
 
-struct SimConfig{ uint32_t seed=12345; int tick_rate=RTS_FIXED_TICK; };
+constexpr int kMaxPlayers = 8;
+
+// Ekonomika a majetek jednoho hráče. 'units' / 'buildings' jsou id vlastněných
+// entit v souvislém poli (přidání na konec, odebrání prohozením s posledním) –
+// dotazy na jednoho hráče tak neprocházejí všechny entity.
+struct Player{
+    int gold=500, wood=0, food_used=0, food_cap=10;
+    std::vector<Vec2i> dropoffs; // hotové sklady hráče (1x1)
+    std::vector<UnitId> units;
+    std::vector<BuildingId> buildings;
+};
+
+struct SimConfig{ uint32_t seed=12345; int tick_rate=RTS_FIXED_TICK;
+    int repath_after_ticks=8; // blokovaná jednotka přepočítá cestu až po N tickách
+};
 
 struct Sim{
     SimConfig cfg;
     Map map;
     std::vector<UnitType> unit_types;
-    std::unordered_map<std::string,uint16_t> unit_type_index;
+    NameIndex unit_type_index; // id z units.csv -> UnitTypeId (jen při načítání / v UI)
+    std::array<BuildingType, kBuildingKinds> building_types = kDefaultBuildingTypes; // buildings.csv / výchozí
     std::vector<Unit> units; uint32_t next_unit_id=1;
     std::vector<Building> buildings; uint32_t next_building_id=1;
-    int gold=500, wood=0, food_used=0, food_cap=10;
-    std::vector<Vec2i> dropoffs; // all drop-off tiles (centers / 1x1)
+    std::vector<Player> players = { Player{} }; // index = owner, viz set_player_count()
+    std::vector<uint32_t> unit_owned_ix, building_owned_ix; // id -> index v Player::units / buildings
+    SpatialHash unit_grid; // slots into 'units', follows Unit::tile
+    std::vector<uint16_t> unit_occ; // units per tile (W*H), follows Unit::tile
+    std::vector<uint32_t> unit_slot; // UnitId -> index in 'units' (UINT32_MAX = none)
+    Fog fog; // per-player visibility from UnitType::sight_tiles, follows Unit::tile
+    std::vector<int32_t> dmg_buf;    // combat: damage accumulated per slot this tick
+    std::vector<uint32_t> slot_remap; std::vector<int> remap_cells; // remove_dead_units: starý slot -> nový
+    uint32_t tick=0;                 // completed steps
+    TimerWheel timers;               // construction / training completions
+    std::vector<BuildingId> build_dirty; // builders changed -> recount construction rate
+    std::vector<TimerEvent> due_events;
+    std::vector<UnitId> awake;       // jednotky, které step() prochází (seřazené podle id)
+    bool awake_sorted=true;
+    uint64_t hash_acc=0;             // inkrementální otisk, viz state_hash.hpp
+    uint64_t tick_hash=0;            // state_hash() na konci posledního step()
+    // odběratelé žurnálu mapy (cache cest, minimapa, ...); load_game() je zachová
+    std::vector<std::pair<int, std::function<void(const Sim&, const std::vector<MapChange>&)>>> map_subs;
+    int next_map_sub=1;
     Sim();
 };
 
-bool load_data(Sim& s, const std::string& assets_path);
-void step(Sim& s, uint32_t dt_ms);
-
-UnitId spawn_unit(Sim& s, const std::string& unit_id, int x, int y);
+// Změna dlaždice za běhu: zapíše jen vrstvy v 'layers', udrží hash, verze bloků
+// a žurnál. Jediná cesta pro úpravy mapy mimo hromadné načtení.
+struct MapEdit{ uint8_t layers=0; uint8_t tile=0, blocked=0, res_kind=0; int res_amount=0, res_max=0; };
+void map_apply(Sim& s, int i, const MapEdit& e);
+inline void map_set_blocked(Sim& s, int i, bool on){ MapEdit e; e.layers=kLayerBlocked; e.blocked=on; map_apply(s, i, e); }
+inline void map_set_tile(Sim& s, int i, uint8_t t){ MapEdit e; e.layers=kLayerTiles; e.tile=t; map_apply(s, i, e); }
+// Odběr změn: 'fn' dostane změny jednoho ticku (na konci step()) nebo map_publish().
+int map_subscribe(Sim& s, std::function<void(const Sim&, const std::vector<MapChange>&)> fn);
+void map_unsubscribe(Sim& s, int id);
+void map_publish(Sim& s); // pošle žurnál odběratelům a vyprázdní ho
+
+bool load_data(Sim& s, const std::string& assets_path); // map.rtsmap (i se surovinami), je-li z aktuálního map.txt, jinak map.txt; sklady hráči 0
+bool set_player_count(Sim& s, int n); // 1..kMaxPlayers; noví hráči s výchozí ekonomikou, přebyteční musí být bez majetku
+void step(Sim& s, uint32_t dt_ms); // přesně jeden tick: dt_ms musí být 1000/cfg.tick_rate (assert)
+
+UnitTypeId unit_type_id(const Sim& s, std::string_view unit_id); // kNoUnitType = neznámý
+UnitId spawn_unit(Sim& s, UnitTypeId type, int x, int y, uint8_t owner=0); // owner >= kMaxPlayers -> 0
+UnitId spawn_unit(Sim& s, std::string_view unit_id, int x, int y, uint8_t owner=0);
+void rebuild_unit_index(Sim& s); // after bulk changes of 's.units' / 's.buildings' (load, removal)
+void remove_dead_units(Sim& s);  // compacts 's.units' (hp<=0), frees food
+Unit* find_unit(Sim& s, UnitId id);
+const Unit* find_unit(const Sim& s, UnitId id);
+bool tile_occupied(const Sim& s, int x, int y);
 void order_move(Sim& s, UnitId u, int gx, int gy);
 void order_gather(Sim& s, UnitId u, int tx, int ty);
+void order_build(Sim& s, UnitId u, BuildingId b); // assign worker, walk to the footprint edge
+void wake_unit(Sim& s, Unit& u, WakeReason why);   // vrátí zaparkovanou jednotku do step()
 
-struct BuildingType{
-    BuildingKind kind; const char* id;
-    int w, h;
-    int cost_gold, cost_wood;
-    int build_ms;
-    int food_cap_bonus;
-};
-
-bool can_place_building(const Sim& s, BuildingType bt, int x, int y);
-BuildingId start_building(Sim& s, BuildingType bt, int x, int y); // deducts resources, reserves tiles
+bool can_place_building(const Sim& s, const BuildingType& bt, int x, int y);
+BuildingId start_building(Sim& s, const BuildingType& bt, int x, int y, uint8_t owner=0); // deducts owner's resources, reserves tiles
 void cancel_building(Sim& s, BuildingId id, bool refund);
 void remove_building(Sim& s, BuildingId id, bool refund);
-Vec2i nearest_dropoff(const Sim& s, Vec2i from);
-BuildingType get_btype(BuildingKind k);
+Vec2i nearest_dropoff(const Sim& s, int owner, Vec2i from); // jen sklady hráče; žádný = 'from'
+// bez kontroly rozsahu: loadery i příkazy odmítají kind >= kBuildingKinds
+inline const BuildingType& get_btype(const Sim& s, BuildingKind k){ assert((int)k < kBuildingKinds); return s.building_types[(size_t)k]; }
+inline bool can_afford(const Player& p, const BuildingType& bt){ return p.gold >= bt.cost_gold && p.wood >= bt.cost_wood; }
 Building* find_building(Sim& s, BuildingId id);
 const Building* find_building(const Sim& s, BuildingId id);
+int building_progress_ms(const Sim& s, const Building& b); // computed on demand from the build rate
+int train_remaining_ms(const Sim& s, const Building& b);   // front of the queue
+void rebuild_timers(Sim& s); // after load: reschedule construction / training
 
 // Production
-bool queue_train(Sim& s, Building& b, const std::string& unit_id, int count);
+bool queue_train(Sim& s, Building& b, UnitTypeId type, int count);
+bool queue_train(Sim& s, Building& b, std::string_view unit_id, int count);
 bool cancel_last_train(Sim& s, Building& b);
 bool cancel_train_at(Sim& s, Building& b, size_t idx);
 
 void init_resources_from_tiles(Sim& sim, int wood_amount=300, int gold_amount=500);
 bool resource_take_at(Sim& s, int x, int y, int amount, int* actually_taken);
-static inline int ridx(const Map& m, int x, int y){ return y*m.width + x; }
 
 // --- Save/Load API ---
-bool save_game(const Sim& s, const std::string& path);
-bool load_game(Sim& s, const std::string& path);
\ No newline at end of file
+bool save_game(const Sim& s, const std::string& path);      // binární VERSION 2, viz savegame.hpp
+bool save_game_text(const Sim& s, const std::string& path); // textový VERSION 1 (ladění, starší verze hry)
+bool load_game(Sim& s, const std::string& path);            // pozná oba formáty
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "sim.hpp"
+
+// Snapshot simulace pro rollback a AI "co kdyby".
+// Dynamický stav (jednotky, budovy, ekonomika, časovače, indexy, fog) se
+// kopíruje do 'state' – opakované snapshot_take() do téhož objektu
+// znovupoužívá jeho alokace. Velká pole mapy se drží po blocích
+// kMapChunk x kMapChunk jako sdílené neměnné kusy: nezměněný blok (stejná
+// verze v Map::chunk_ver) se nekopíruje ani při pořízení, ani při obnově,
+// a kopie snapshotu bloky jen sdílí (copy-on-write).
+struct MapChunk{
+    std::vector<uint8_t> tiles, blocked, res_kind;
+    std::vector<int> res_amount, res_max;
+};
+
+struct SimSnapshot{
+    Sim state; // vše kromě mapy (state.map zůstává prázdná)
+    int map_w=0, map_h=0;
+    std::vector<std::shared_ptr<const MapChunk>> chunks;
+    std::vector<uint32_t> chunk_ver;
+};
+
+bool snapshot_take(const Sim& s, SimSnapshot& out);
+// Obnoví stav; kopíruje jen bloky mapy, jejichž verze se od snapshotu změnila.
+bool snapshot_restore(Sim& s, const SimSnapshot& snap);
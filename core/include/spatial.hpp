@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+struct Unit; struct Vec2i;
+
+// Uniform grid (cell-bucketed spatial hash) of units.
+// Buckets hold slot indices into Sim::units; the owner keeps them in sync
+// with Unit::tile (spatial_move on every tile change, rebuild after compaction).
+struct SpatialHash{
+    int cell_shift=3;   // cell = (1<<cell_shift)^2 tiles
+    int cols=0, rows=0;
+    int map_w=0, map_h=0;
+    std::vector<std::vector<uint32_t>> cells;
+};
+
+void spatial_init(SpatialHash& h, int map_w, int map_h, int cell_shift=3);
+void spatial_clear(SpatialHash& h);
+void spatial_insert(SpatialHash& h, uint32_t slot, Vec2i t);
+void spatial_remove(SpatialHash& h, uint32_t slot, Vec2i t);
+void spatial_move(SpatialHash& h, uint32_t slot, Vec2i from, Vec2i to);
+// Kompakce slotů: buňka 'cell' dostane remap[slot] (UINT32_MAX = odebrat), pořadí zůstává.
+int spatial_cell(const SpatialHash& h, Vec2i t);
+void spatial_remap_cell(SpatialHash& h, int cell, const std::vector<uint32_t>& remap);
+
+// Queries append matching slots to 'out' (not cleared). Bounds are inclusive tiles.
+void spatial_query_rect(const SpatialHash& h, const std::vector<Unit>& units,
+                        int x0, int y0, int x1, int y1, std::vector<uint32_t>& out);
+void spatial_query_radius(const SpatialHash& h, const std::vector<Unit>& units,
+                          Vec2i c, int r, std::vector<uint32_t>& out);
+// k nejbližších (euklidovsky), seřazeno od nejbližší; max_r<0 = bez omezení
+void spatial_knearest(const SpatialHash& h, const std::vector<Unit>& units,
+                      Vec2i c, int k, std::vector<uint32_t>& out, int max_r=-1);
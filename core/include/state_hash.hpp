@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+struct Sim; struct Unit; struct Building; struct Map;
+
+// 64bit otisk stavu pro detekci desynchronizace (lockstep, replay).
+// Sim::hash_acc je XOR příspěvků jednotek, budov a dlaždic mapy; každá mutace
+// odebere starý příspěvek a přidá nový (XOR dvakrát). Ekonomika a tick se
+// přimíchají až při čtení.
+
+inline uint64_t hash_mix(uint64_t x){ // splitmix64 finalizer
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+inline uint64_t hash_pair(int32_t a, int32_t b){ return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b; }
+
+uint64_t hash_unit(const Unit& u);         // id, typ, vlastník, dlaždice, hp, náklad, job, cíl, cooldown
+uint64_t hash_building(const Building& b); // id, druh, pozice, stav stavby, fronta
+uint64_t hash_tile(const Map& m, int i);   // tiles, blocked, res_kind, res_amount
+
+// Úpravy jednotky v bloku: příspěvek se odebere při vstupu a přidá při opuštění
+// (i přes return/continue). Uvnitř bloku se hash_unit té jednotky už nepřepočítává.
+struct UnitHashScope{
+    uint64_t& acc; const Unit& u;
+    UnitHashScope(uint64_t& a, const Unit& x): acc(a), u(x){ acc ^= hash_unit(u); }
+    ~UnitHashScope(){ acc ^= hash_unit(u); }
+};
+
+uint64_t state_hash(const Sim& s);      // O(1), z inkrementálního Sim::hash_acc
+uint64_t state_hash_full(const Sim& s); // přepočet od nuly (ověření)
+void rebuild_state_hash(Sim& s);        // po hromadné změně (načtení mapy, load)
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+enum class TimerKind : uint8_t { TrainDone=0, BuildDone=1, UnitWake=2 };
+
+// 'gen' se porovná s generací v cílové entitě; přeplánování jen zvýší generaci
+// a staré události se při vyvolání zahodí (žádné mazání z kola).
+struct TimerEvent{ uint32_t due_tick; TimerKind kind; uint32_t id; uint32_t gen; };
+
+// Hierarchické časové kolo: 4 úrovně po 64 slotech (6 bitů tiku na úroveň),
+// vzdálenější události v 'overflow'. Cena tiku ~ počet splatných událostí.
+struct TimerWheel{
+    static constexpr int kLevels=4, kBits=6, kSlots=1<<kBits;
+    uint32_t now=0; // poslední zpracovaný tick
+    std::vector<TimerEvent> slots[kLevels][kSlots];
+    std::vector<TimerEvent> overflow;
+    std::vector<TimerEvent> ready; // due <= now při naplánování
+};
+
+void timer_reset(TimerWheel& w, uint32_t now);
+void timer_schedule(TimerWheel& w, const TimerEvent& ev);
+// Posune kolo na 'tick' a připojí splatné události do 'out' (v pořadí plánování v rámci slotu).
+void timer_advance(TimerWheel& w, uint32_t tick, std::vector<TimerEvent>& out);
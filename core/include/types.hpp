@@ -1,10 +1,13 @@
 
 #pragma once
+#include <array>
 #include <cstdint>
 #include <vector>
 #include <string>
 using UnitId = uint32_t;
 using BuildingId = uint32_t;
+using UnitTypeId = uint16_t; // index do Sim::unit_types
+constexpr UnitTypeId kNoUnitType = UINT16_MAX;
 
 enum class ArmorType : uint8_t { Light, Medium, Heavy, Building };
 enum class AttackType : uint8_t { Normal, Pierce, Siege, Magic };
@@ -17,4 +20,20 @@ struct UnitType{
 };
 
 enum class BuildingKind : uint8_t { Dropoff=0, Farm=1, Barracks=2 };
+constexpr int kBuildingKinds = 3;
+
+struct BuildingType{
+    BuildingKind kind; const char* id;
+    int w, h;
+    int cost_gold, cost_wood;
+    int build_ms;
+    int food_cap_bonus;
+};
+// Výchozí tabulka (indexovaná BuildingKind); buildings.csv ji může přepsat po řádcích.
+constexpr std::array<BuildingType, kBuildingKinds> kDefaultBuildingTypes = {{
+    { BuildingKind::Dropoff,  "dropoff",  1,1, 120,  0, 1500, 0 },
+    { BuildingKind::Farm,     "farm",     1,1,  60, 40, 1200, 4 },
+    { BuildingKind::Barracks, "barracks", 2,2, 150, 80, 5000, 0 },
+}};
+static_assert(kDefaultBuildingTypes[(int)BuildingKind::Barracks].kind==BuildingKind::Barracks, "tabulka v pořadí BuildingKind");
 enum class BuildState : uint8_t { Planned=0, Constructing=1, Complete=2, Canceled=3 };
@@ -0,0 +1,80 @@
+#include "async_save.hpp"
+#include "savegame.hpp"
+#include "mapped_file.hpp"
+#include "prof.hpp"
+#include <chrono>
+#include <map>
+
+static void run(AsyncSaver& a){
+    Sim work; // pracovní kopie; snapshot_restore() přepisuje jen změněné bloky mapy
+    std::vector<uint8_t> buf;
+    std::map<std::string, SaveChain> chains; // keyframe pro každý soubor delt
+    for(;;){
+        AsyncSaver::Job job;
+        {
+            std::unique_lock<std::mutex> lk(a.mu);
+            a.cv.wait(lk, [&]{ return a.quit || !a.jobs.empty(); });
+            if(a.jobs.empty()) return;
+            job = std::move(a.jobs.front()); a.jobs.pop_front();
+            a.busy = true;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        SaveResult r; r.path = job.path; r.tag = job.tag;
+        {
+            RTS_PROF_SCOPE("async_save");
+            work.unit_types = std::move(job.types);
+            r.ok = snapshot_restore(work, *job.snap);
+            job.snap.reset();
+            if(r.ok && job.delta) r.ok = save_game_chain(work, chains[job.path], job.path, &r.chunks);
+            else if(r.ok){ save_encode(work, buf); r.ok = write_file_atomic(job.path, buf.data(), buf.size()); r.chunks = (size_t)-1; }
+        }
+        r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        {
+            std::lock_guard<std::mutex> lk(a.mu);
+            a.done.push_back(r);
+            a.busy = false;
+        }
+        a.cv.notify_all();
+    }
+}
+
+AsyncSaver::AsyncSaver(){ worker = std::thread(run, std::ref(*this)); }
+
+AsyncSaver::~AsyncSaver(){
+    { std::lock_guard<std::mutex> lk(mu); quit = true; }
+    cv.notify_all();
+    if(worker.joinable()) worker.join(); // fronta se před koncem vyprázdní
+}
+
+bool async_save_request(AsyncSaver& a, const Sim& s, const std::string& path, int tag, bool delta){
+    RTS_PROF_SCOPE("async_save_request");
+    // nový snapshot začne s bloky minulého – změněné bloky dostanou novou kopii,
+    // sdílené (use_count > 1) se nikdy nepřepisují na místě, takže vlákno čte bezpečně
+    auto snap = std::make_shared<SimSnapshot>();
+    snap->map_w = a.last.map_w; snap->map_h = a.last.map_h;
+    snap->chunks = a.last.chunks; snap->chunk_ver = a.last.chunk_ver;
+    if(!snapshot_take(s, *snap)) return false;
+    a.last.map_w = snap->map_w; a.last.map_h = snap->map_h;
+    a.last.chunks = snap->chunks; a.last.chunk_ver = snap->chunk_ver;
+    AsyncSaver::Job job{ std::move(snap), s.unit_types, path, tag, delta };
+    {
+        std::lock_guard<std::mutex> lk(a.mu);
+        // starší nevyřízený zápis do stejného souboru je zbytečný
+        for(auto it=a.jobs.begin(); it!=a.jobs.end();) it = it->path==path ? a.jobs.erase(it) : it+1;
+        a.jobs.push_back(std::move(job));
+    }
+    a.cv.notify_all();
+    return true;
+}
+
+bool async_save_poll(AsyncSaver& a, SaveResult& out){
+    std::lock_guard<std::mutex> lk(a.mu);
+    if(a.done.empty()) return false;
+    out = a.done.front(); a.done.pop_front();
+    return true;
+}
+
+void async_save_wait(AsyncSaver& a){
+    std::unique_lock<std::mutex> lk(a.mu);
+    a.cv.wait(lk, [&]{ return a.jobs.empty() && !a.busy; });
+}
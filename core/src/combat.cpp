@@ -0,0 +1,96 @@
+#include "combat.hpp"
+#include "sim.hpp"
+#include "pathfinding.hpp"
+#include "state_hash.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+static inline int cheb(Vec2i a, Vec2i b){ return std::max(std::abs(a.x-b.x), std::abs(a.y-b.y)); }
+
+void order_attack(Sim& s, UnitId u, UnitId target){
+    Unit* e = find_unit(s,u);
+    const Unit* t = find_unit(s,target);
+    if(!e || !t || t->owner==e->owner) return;
+    UnitHashScope hs(s.hash_acc, *e);
+    if(e->job==UnitJob::Building && e->building_target) s.build_dirty.push_back(e->building_target);
+    wake_unit(s, *e, WakeReason::Order);
+    e->job = UnitJob::Attacking; e->target = target;
+    e->goal = t->tile; e->path.clear();
+    astar_find(s.map, e->tile, e->goal, e->path, true);
+}
+
+// nejbližší nepřítel v dohledu (jen kandidáti z unit_grid)
+static UnitId acquire_target(const Sim& s, const Unit& e, int sight, std::vector<uint32_t>& scratch){
+    scratch.clear();
+    spatial_query_radius(s.unit_grid, s.units, e.tile, sight, scratch);
+    int best = std::numeric_limits<int>::max(); UnitId ret = 0;
+    for(uint32_t slot: scratch){
+        const Unit& o = s.units[slot];
+        if(o.owner==e.owner || o.hp<=0) continue;
+        int dx=o.tile.x-e.tile.x, dy=o.tile.y-e.tile.y;
+        int d = dx*dx+dy*dy;
+        if(d<best || (d==best && o.id<ret)){ best=d; ret=o.id; }
+    }
+    return ret;
+}
+
+void combat_step(Sim& s, uint32_t dt_ms){
+    const size_t n = s.units.size();
+    s.dmg_buf.assign(n, 0);
+    std::vector<uint32_t> scratch;
+    bool any_hit = false;
+
+    for(size_t k=0;k<s.awake.size();++k){
+        Unit* pe = find_unit(s, s.awake[k]);
+        if(!pe) continue;
+        Unit& e = *pe;
+        UnitHashScope hs(s.hash_acc, e); // cooldown, cíl, job, goal
+        const UnitType& ut = s.unit_types[e.type_index];
+        e.cooldown = (uint16_t)(e.cooldown > dt_ms ? e.cooldown - dt_ms : 0);
+        if(ut.attack.damage<=0) continue;
+        // hráčské příkazy (pohyb, těžba, stavba) mají přednost před automatickým bojem
+        if(e.job!=UnitJob::Idle && e.job!=UnitJob::Attacking) continue;
+
+        const bool slow_tick = ((s.tick + e.id) % kAcquireEvery)==0;
+        const Unit* t = find_unit(s, e.target);
+        if(t && cheb(t->tile, e.tile) > ut.sight_tiles + 2) t = nullptr; // ztratil se z dohledu
+        if(!t){
+            e.target = 0;
+            if(slow_tick) e.target = acquire_target(s, e, ut.sight_tiles, scratch);
+            t = find_unit(s, e.target);
+            if(!t){
+                if(e.job==UnitJob::Attacking){ e.job=UnitJob::Idle; e.path.clear(); }
+                continue;
+            }
+            e.job = UnitJob::Attacking;
+        }
+
+        const int range = std::max<int>(1, ut.attack.range_tiles);
+        if(cheb(t->tile, e.tile) <= range){
+            e.path.clear();
+            if(e.cooldown==0){
+                s.dmg_buf[s.unit_slot[t->id]] += combat_damage(ut.attack, s.unit_types[t->type_index].armor);
+                e.cooldown = ut.attack.cooldown_ms;
+                any_hit = true;
+            }
+        }else if(slow_tick && (e.path.empty() || cheb(e.goal, t->tile) > range)){
+            // pronásleduj: cesta k aktuální pozici cíle (přepočítá se, až cíl uteče)
+            e.goal = t->tile; e.path.clear();
+            astar_find(s.map, e.tile, e.goal, e.path, true, 2048);
+        }
+    }
+    if(!any_hit) return;
+
+    // dávkové uplatnění poškození
+    bool any_dead = false;
+    for(size_t i=0;i<n;++i){
+        if(!s.dmg_buf[i]) continue;
+        s.hash_acc ^= hash_unit(s.units[i]);
+        s.units[i].hp -= s.dmg_buf[i];
+        s.hash_acc ^= hash_unit(s.units[i]);
+        if(s.units[i].hp<=0) any_dead = true;
+        else wake_unit(s, s.units[i], WakeReason::Attacked);
+    }
+    if(any_dead) remove_dead_units(s);
+}
@@ -0,0 +1,101 @@
+#include "commands.hpp"
+#include "sim.hpp"
+#include "combat.hpp"
+#include "state_hash.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+uint32_t apply_command(Sim& s, const Command& c){
+    if(c.player >= s.players.size()) return 0;
+    if(const Unit* u = find_unit(s, c.unit)) if(u->owner!=c.player) return 0; // cizí jednotka
+    switch(c.type){
+        case CmdType::Move:   order_move(s, c.unit, c.x, c.y); return 1;
+        case CmdType::Gather: order_gather(s, c.unit, c.x, c.y); return 1;
+        case CmdType::Build:  order_build(s, c.unit, c.arg); return 1;
+        case CmdType::Attack: order_attack(s, c.unit, c.arg); return 1;
+        case CmdType::PlaceBuilding:
+            if(c.arg >= (uint32_t)kBuildingKinds) return 0;
+            return start_building(s, get_btype(s, (BuildingKind)c.arg), c.x, c.y, c.player);
+        default: break;
+    }
+    Building* b = find_building(s, c.arg);
+    if(!b || b->owner!=c.player) return 0;
+    switch(c.type){
+        case CmdType::Train:
+            if(c.x<0 || c.x>=(int)s.unit_types.size()) return 0;
+            return queue_train(s, *b, (UnitTypeId)c.x, c.y) ? 1 : 0;
+        case CmdType::CancelLastTrain: return cancel_last_train(s, *b) ? 1 : 0;
+        case CmdType::CancelTrainAt:   return c.x>=0 && cancel_train_at(s, *b, (size_t)c.x) ? 1 : 0;
+        case CmdType::RemoveBuilding:  remove_building(s, c.arg, true); return 1;
+        case CmdType::SetRally:        b->rally = { c.x, c.y }; return 1;
+        default: return 0;
+    }
+}
+
+uint32_t submit_command(Sim& s, CommandLog* log, Command c){
+    c.tick = s.tick;
+    if(log) log->cmds.push_back(c);
+    return apply_command(s, c);
+}
+
+bool save_command_log(const CommandLog& log, const std::string& path){
+    std::ofstream f(path, std::ios::trunc);
+    if(!f) return false;
+    f << "RTSREPLAY 1\n";
+    f << "INIT " << log.assets << " " << log.wood_amount << " " << log.gold_amount << " " << log.players << "\n";
+    for(const auto& c: log.cmds)
+        f << "C " << c.tick << " " << (int)c.type << " " << c.unit << " " << c.x << " " << c.y << " " << c.arg << " " << (int)c.player << "\n";
+    char hex[32]; std::snprintf(hex, sizeof(hex), "%016" PRIx64, log.end_hash);
+    f << "END " << log.end_tick << " " << hex << "\n";
+    return (bool)f;
+}
+
+bool load_command_log(CommandLog& out, const std::string& path){
+    std::ifstream f(path);
+    if(!f) return false;
+    CommandLog log;
+    std::string line, tag;
+    if(!std::getline(f, line) || line.rfind("RTSREPLAY 1", 0)!=0) return false;
+    while(std::getline(f, line)){
+        std::istringstream ss(line);
+        if(!(ss >> tag)) continue;
+        if(tag=="INIT"){
+            ss >> log.assets >> log.wood_amount >> log.gold_amount;
+            if(!(ss >> log.players)) log.players = 1; // starší záznamy bez počtu hráčů
+            if(log.players<1 || log.players>kMaxPlayers) return false;
+        }else if(tag=="C"){
+            Command c; int type=0;
+            if(!(ss >> c.tick >> type >> c.unit >> c.x >> c.y >> c.arg)) return false;
+            if(type<0 || type>(int)CmdType::SetRally) return false;
+            int player=0;
+            if(!(ss >> player)) player=0; // starší záznamy: vše hráč 0
+            if(player<0 || player>=kMaxPlayers) return false;
+            c.type = (CmdType)type; c.player = (uint8_t)player;
+            if(!log.cmds.empty() && c.tick < log.cmds.back().tick) return false; // musí být seřazené
+            log.cmds.push_back(c);
+        }else if(tag=="END"){
+            std::string hex;
+            ss >> log.end_tick >> hex;
+            log.end_hash = std::strtoull(hex.c_str(), nullptr, 16);
+        }
+    }
+    out = std::move(log);
+    return true;
+}
+
+bool replay_run(Sim& s, const CommandLog& log, uint32_t dt_ms){
+    if(!load_data(s, log.assets)) return false;
+    if(s.map.res_kind.empty()) init_resources_from_tiles(s, log.wood_amount, log.gold_amount); // .rtsmap má vlastní
+    if(!set_player_count(s, log.players)) return false; // jinak by apply_command zahodil příkazy hráčů 1..
+    size_t next = 0;
+    uint32_t end = log.end_tick;
+    if(!log.cmds.empty() && log.cmds.back().tick > end) end = log.cmds.back().tick;
+    for(;;){
+        while(next < log.cmds.size() && log.cmds[next].tick == s.tick) apply_command(s, log.cmds[next++]);
+        if(s.tick >= end) break;
+        step(s, dt_ms);
+    }
+    return log.end_hash==0 || state_hash(s)==log.end_hash;
+}
@@ -2,34 +2,162 @@
 #include "data.hpp"
 #include "sim.hpp"
 #include "types.hpp"
-#include <fstream>
-#include <sstream>
+#include "mapped_file.hpp"
+#include "name_index.hpp"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
 #include <cstdio>
+#include <fstream>
+#include <string_view>
+#include <unordered_set>
 
-bool load_units_csv(const std::string& path, std::vector<UnitType>& out, std::unordered_map<std::string,uint16_t>& index){
-    std::ifstream f(path);
-    if(!f.good()){ std::fprintf(stderr,"Failed to open %s\n", path.c_str()); return false; }
-    std::string line; std::getline(f,line);
-    while(std::getline(f,line)){
-        if(line.empty()) continue;
-        std::stringstream ss(line); std::string tok; UnitType t; Attack a; Armor ar;
-        std::getline(ss,t.id,',');
-        std::getline(ss,tok,','); t.hp=std::stoi(tok);
-        std::getline(ss,tok,','); t.move_speed_px_s=std::stoi(tok);
-        std::getline(ss,tok,','); a.type=(tok=="Pierce"?AttackType::Pierce: tok=="Siege"?AttackType::Siege: tok=="Magic"?AttackType::Magic: AttackType::Normal);
-        std::getline(ss,tok,','); a.damage=(int16_t)std::stoi(tok);
-        std::getline(ss,tok,','); a.cooldown_ms=(uint16_t)std::stoi(tok);
-        std::getline(ss,tok,','); a.range_tiles=(uint16_t)::std::stoi(tok);
-        std::getline(ss,tok,','); ar.type=(tok=="Light"?ArmorType::Light: tok=="Heavy"?ArmorType::Heavy: tok=="Building"?ArmorType::Building: ArmorType::Medium);
-        std::getline(ss,tok,','); ar.value=(int16_t)std::stoi(tok);
-        std::getline(ss,tok,','); t.sight_tiles=std::stoi(tok);
-        std::getline(ss,tok,','); t.cost_gold=std::stoi(tok);
-        std::getline(ss,tok,','); t.cost_wood=std::stoi(tok);
-        std::getline(ss,tok,','); t.food=std::stoi(tok);
-        std::getline(ss,tok,','); t.build_time_ms=std::stoi(tok);
+// units.csv: sloupce se hledají podle jména v hlavičce (pořadí libovolné, navíc
+// sloupce se ignorují). Jeden průchod nad namapovaným souborem, čísla přes
+// from_chars – špatný řádek se ohlásí (soubor:řádek) a přeskočí.
+enum UnitCol{ cId, cHp, cMove, cAttackType, cDamage, cCooldown, cRange, cArmorType, cArmor, cSight,
+              cGold, cWood, cFood, cBuildTime, kUnitCols };
+static const char* const kUnitColNames[kUnitCols] = { "id", "hp", "move_px_s", "attackType", "damage", "cooldown_ms",
+    "range_tiles", "armorType", "armor", "sight", "cost_gold", "cost_wood", "food", "build_time_ms" };
+
+static std::string_view trim(std::string_view v){
+    while(!v.empty() && (v.front()==' ' || v.front()=='\t')) v.remove_prefix(1);
+    while(!v.empty() && (v.back()==' ' || v.back()=='\t' || v.back()=='\r')) v.remove_suffix(1);
+    return v;
+}
+static void split_csv(std::string_view line, std::vector<std::string_view>& f){
+    f.clear();
+    for(;;){
+        size_t c = line.find(',');
+        f.push_back(trim(line.substr(0, c)));
+        if(c == std::string_view::npos) return;
+        line.remove_prefix(c + 1);
+    }
+}
+template<class T> static bool parse_int(std::string_view v, T& out, long lo, long hi){
+    long x = 0;
+    auto r = std::from_chars(v.data(), v.data() + v.size(), x);
+    if(r.ec != std::errc() || r.ptr != v.data() + v.size() || x < lo || x > hi) return false;
+    out = (T)x; return true;
+}
+static bool parse_attack_type(std::string_view v, AttackType& t){
+    if(v=="Normal") t=AttackType::Normal; else if(v=="Pierce") t=AttackType::Pierce;
+    else if(v=="Siege") t=AttackType::Siege; else if(v=="Magic") t=AttackType::Magic; else return false;
+    return true;
+}
+static bool parse_armor_type(std::string_view v, ArmorType& t){
+    if(v=="Light") t=ArmorType::Light; else if(v=="Medium") t=ArmorType::Medium;
+    else if(v=="Heavy") t=ArmorType::Heavy; else if(v=="Building") t=ArmorType::Building; else return false;
+    return true;
+}
+
+// CSV nad namapovaným souborem: sloupce podle jmen v hlavičce, řádky jako string_view pole.
+namespace {
+struct CsvFile{
+    MappedFile mf; std::string path; std::string_view text;
+    std::vector<std::string_view> f; std::vector<int> col;
+    int lineno = 0;
+
+    bool open(const std::string& p, const char* const* names, int n, bool quiet_missing=false){
+        path = p;
+        if(!mapped_open(mf, path)){ if(!quiet_missing) std::fprintf(stderr,"Failed to open %s\n", path.c_str()); return false; }
+        text = std::string_view(reinterpret_cast<const char*>(mf.data), mf.size);
+        if(text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3); // UTF-8 BOM
+        std::string_view line;
+        if(!next_line(line)){ std::fprintf(stderr,"%s: missing header\n", path.c_str()); return false; }
+        split_csv(line, f);
+        col.assign(n, -1);
+        for(int c=0;c<n;++c){
+            for(size_t k=0;k<f.size();++k) if(f[k]==names[c]){ col[c]=(int)k; break; }
+            if(col[c] < 0){ std::fprintf(stderr,"%s:1: missing column '%s'\n", path.c_str(), names[c]); return false; }
+        }
+        return true;
+    }
+    bool next_line(std::string_view& line){
+        if(text.empty()) return false;
+        size_t nl = text.find('\n');
+        line = text.substr(0, nl);
+        text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+        ++lineno;
+        return true;
+    }
+    bool next_row(){ // prázdné řádky přeskočí
+        std::string_view line;
+        while(next_line(line)) if(!trim(line).empty()){ split_csv(line, f); return true; }
+        return false;
+    }
+    // horní odhad z velikosti (platný řádek má aspoň 'cols' bajtů: cols-1 čárek + id/konec řádku), bez průchodu souborem
+    size_t rows_max(int cols) const { return text.size() / (size_t)cols + 1; }
+    std::string_view field(int c) const { return (size_t)col[c] < f.size() ? f[col[c]] : std::string_view(); }
+    void fail(const char* what, const char* column) const {
+        std::fprintf(stderr,"%s:%d: %s '%s', row skipped\n", path.c_str(), lineno, what, column);
+    }
+};
+}
+
+bool load_units_csv(const std::string& path, std::vector<UnitType>& out, NameIndex& index){
+    CsvFile csv;
+    if(!csv.open(path, kUnitColNames, kUnitCols)) return false;
+    const size_t rows = std::min<size_t>(csv.rows_max(kUnitCols), kNoUnitType); // víc typů se nenačte
+    out.reserve(out.size() + rows);
+    std::unordered_set<std::string_view> seen; seen.reserve(out.size() + rows);
+    for(const auto& t: out) seen.insert(t.id); // díky reserve() se 'out' nerealokuje
+
+    while(csv.next_row()){
+        bool ok = true;
+        UnitType t{}; Attack a{}; Armor ar{};
+        auto num = [&](int c, auto& v, long lo, long hi){
+            if(ok && !parse_int(csv.field(c), v, lo, hi)){ csv.fail(csv.field(c).empty() ? "missing" : "invalid", kUnitColNames[c]); ok=false; }
+        };
+        num(cHp, t.hp, 1, 1000000);
+        num(cMove, t.move_speed_px_s, 0, 100000);
+        num(cDamage, a.damage, INT16_MIN, INT16_MAX);
+        num(cCooldown, a.cooldown_ms, 0, UINT16_MAX);
+        num(cRange, a.range_tiles, 0, UINT16_MAX);
+        num(cArmor, ar.value, INT16_MIN, INT16_MAX);
+        num(cSight, t.sight_tiles, 0, 1000);
+        num(cGold, t.cost_gold, 0, 1000000);
+        num(cWood, t.cost_wood, 0, 1000000);
+        num(cFood, t.food, 0, 1000);
+        num(cBuildTime, t.build_time_ms, 0, 3600000);
+        if(ok && !parse_attack_type(csv.field(cAttackType), a.type)){ csv.fail("unknown", kUnitColNames[cAttackType]); ok=false; }
+        if(ok && !parse_armor_type(csv.field(cArmorType), ar.type)){ csv.fail("unknown", kUnitColNames[cArmorType]); ok=false; }
+        const std::string_view id = csv.field(cId);
+        if(ok && id.empty()){ csv.fail("missing", kUnitColNames[cId]); ok=false; }
+        if(!ok) continue;
+        if(!seen.insert(id).second){ csv.fail("duplicate", kUnitColNames[cId]); continue; }
+        if(out.size() >= kNoUnitType){ std::fprintf(stderr,"%s:%d: too many unit types\n", path.c_str(), csv.lineno); break; }
+        t.id.assign(id.data(), id.size());
         t.attack=a; t.armor=ar;
-        index[t.id]=(uint16_t)out.size();
-        out.push_back(t);
+        out.push_back(std::move(t));
+    }
+    std::vector<std::string> ids; ids.reserve(out.size());
+    for(const auto& t: out) ids.push_back(t.id);
+    return name_index_build(index, ids);
+}
+
+// buildings.csv: řádek přepíše výchozí typ se stejným id (druhy budov jsou dané kódem).
+enum BuildingCol{ bId, bW, bH, bGold, bWood, bBuildMs, bFood, kBuildingCols };
+static const char* const kBuildingColNames[kBuildingCols] = { "id", "w", "h", "cost_gold", "cost_wood", "build_ms", "food_cap_bonus" };
+
+bool load_buildings_csv(const std::string& path, std::array<BuildingType, kBuildingKinds>& out){
+    CsvFile csv;
+    if(!csv.open(path, kBuildingColNames, kBuildingCols, /*quiet_missing=*/true)) return false;
+    while(csv.next_row()){
+        int k = 0;
+        while(k<kBuildingKinds && csv.field(bId)!=kDefaultBuildingTypes[k].id) ++k;
+        if(k==kBuildingKinds){ csv.fail("unknown", kBuildingColNames[bId]); continue; }
+        BuildingType bt = kDefaultBuildingTypes[k];
+        bool ok = true;
+        if(bt.kind==BuildingKind::Dropoff && (csv.field(bW)!="1" || csv.field(bH)!="1")){ csv.fail("dropoff must be 1x1,", kBuildingColNames[bW]); continue; }
+        auto num = [&](int c, int& v, long lo, long hi){
+            if(ok && !parse_int(csv.field(c), v, lo, hi)){ csv.fail(csv.field(c).empty() ? "missing" : "invalid", kBuildingColNames[c]); ok=false; }
+        };
+        num(bW, bt.w, 1, 8); num(bH, bt.h, 1, 8);
+        num(bGold, bt.cost_gold, 0, 1000000); num(bWood, bt.cost_wood, 0, 1000000);
+        num(bBuildMs, bt.build_ms, 1, 3600000); num(bFood, bt.food_cap_bonus, 0, 1000);
+        if(ok) out[k] = bt;
     }
     return true;
 }
@@ -56,3 +184,15 @@ bool load_map_txt(const std::string& path, Map& out){
     }
     return true;
 }
+
+bool save_map_txt(const Map& m, const std::string& path){
+    std::ofstream f(path, std::ios::trunc | std::ios::binary);
+    if(!f) return false;
+    static const char glyph[] = ".#GTD";
+    std::string line((size_t)m.width + 1, '\n');
+    for(int y=0;y<m.height;++y){
+        for(int x=0;x<m.width;++x){ uint8_t t = m.tiles[(size_t)y*m.width + x]; line[x] = t<5 ? glyph[t] : '.'; }
+        f.write(line.data(), (std::streamsize)line.size());
+    }
+    return (bool)f;
+}
@@ -0,0 +1,112 @@
+#include "fog.hpp"
+#include "sim.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+static const int kDir[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+
+static inline bool in_disc(int dx, int dy, int r){ return dx*dx + dy*dy <= r*r + r; }
+
+static int dir_index(int dx, int dy){
+    for(int i=0;i<8;++i) if(kDir[i][0]==dx && kDir[i][1]==dy) return i;
+    return -1;
+}
+
+static const DiscStamp& stamp_for(Fog& f, int r){
+    if(r < (int)f.stamps.size() && !f.stamps[r].disc.empty()) return f.stamps[r];
+    if(r >= (int)f.stamps.size()) f.stamps.resize(r+1);
+    DiscStamp& st = f.stamps[r];
+    for(int dy=-r; dy<=r; ++dy) for(int dx=-r; dx<=r; ++dx)
+        if(in_disc(dx,dy,r)) st.disc.push_back({(int16_t)dx,(int16_t)dy});
+    for(int d=0; d<8; ++d){
+        const int mx=kDir[d][0], my=kDir[d][1];
+        for(const auto& o: st.disc){
+            // stará pozice = 0, nová = (mx,my)
+            if(!in_disc(o.dx-mx, o.dy-my, r)) st.leave[d].push_back(o);
+            if(!in_disc(o.dx+mx, o.dy+my, r)) st.enter[d].push_back(o);
+        }
+    }
+    return st;
+}
+
+static FogLayer& layer_for(Fog& f, int player){
+    if(player >= (int)f.players.size()) f.players.resize(player+1);
+    FogLayer& L = f.players[player];
+    if(L.w!=f.w || L.h!=f.h){
+        L.w=f.w; L.h=f.h; L.words_per_row=(f.w+63)/64;
+        L.count.assign((size_t)f.w*f.h, 0);
+        L.visible.assign((size_t)L.words_per_row*f.h, 0);
+        L.explored.assign((size_t)L.words_per_row*f.h, 0);
+    }
+    return L;
+}
+
+static inline void inc(FogLayer& L, int x, int y){
+    if(x<0||y<0||x>=L.w||y>=L.h) return;
+    if(L.count[(size_t)y*L.w+x]++ == 0){
+        uint64_t bit = 1ull << (x & 63);
+        size_t wi = (size_t)y*L.words_per_row + (x>>6);
+        L.visible[wi] |= bit; L.explored[wi] |= bit;
+    }
+}
+static inline void dec(FogLayer& L, int x, int y){
+    if(x<0||y<0||x>=L.w||y>=L.h) return;
+    if(--L.count[(size_t)y*L.w+x] == 0)
+        L.visible[(size_t)y*L.words_per_row + (x>>6)] &= ~(1ull << (x & 63));
+}
+
+void fog_init(Fog& f, int w, int h){
+    f.w=w; f.h=h;
+    f.players.clear();
+}
+
+void fog_add_unit(Fog& f, int player, Vec2i t, int radius){
+    if(radius<0 || f.w<=0) return;
+    const DiscStamp& st = stamp_for(f, radius);
+    FogLayer& L = layer_for(f, player);
+    for(const auto& o: st.disc) inc(L, t.x+o.dx, t.y+o.dy);
+}
+
+void fog_remove_unit(Fog& f, int player, Vec2i t, int radius){
+    if(radius<0 || f.w<=0) return;
+    const DiscStamp& st = stamp_for(f, radius);
+    FogLayer& L = layer_for(f, player);
+    for(const auto& o: st.disc) dec(L, t.x+o.dx, t.y+o.dy);
+}
+
+void fog_move_unit(Fog& f, int player, Vec2i from, Vec2i to, int radius){
+    if(radius<0 || f.w<=0) return;
+    int d = dir_index(to.x-from.x, to.y-from.y);
+    if(d<0){
+        if(from.x==to.x && from.y==to.y) return;
+        fog_remove_unit(f, player, from, radius);
+        fog_add_unit(f, player, to, radius);
+        return;
+    }
+    const DiscStamp& st = stamp_for(f, radius);
+    FogLayer& L = layer_for(f, player);
+    // nejdřív přidat, pak ubrat – dlaždice v průniku nikdy nespadnou na 0
+    for(const auto& o: st.enter[d]) inc(L, to.x+o.dx, to.y+o.dy);
+    for(const auto& o: st.leave[d]) dec(L, from.x+o.dx, from.y+o.dy);
+}
+
+void fog_clear_visible(Fog& f){
+    for(auto& L: f.players){
+        std::fill(L.count.begin(), L.count.end(), 0);
+        std::fill(L.visible.begin(), L.visible.end(), 0);
+    }
+}
+
+bool fog_visible(const Fog& f, int player, int x, int y){
+    if(player<0 || player>=(int)f.players.size()) return false;
+    const FogLayer& L = f.players[player];
+    if(x<0||y<0||x>=L.w||y>=L.h) return false;
+    return (L.visible[(size_t)y*L.words_per_row + (x>>6)] >> (x & 63)) & 1;
+}
+
+bool fog_explored(const Fog& f, int player, int x, int y){
+    if(player<0 || player>=(int)f.players.size()) return false;
+    const FogLayer& L = f.players[player];
+    if(x<0||y<0||x>=L.w||y>=L.h) return false;
+    return (L.explored[(size_t)y*L.words_per_row + (x>>6)] >> (x & 63)) & 1;
+}
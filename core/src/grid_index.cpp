@@ -0,0 +1,39 @@
+#include "grid_index.hpp"
+
+// bity v rozprostřené na sudé pozice (0b1011 -> 0b1000101)
+static uint32_t spread_bits(uint32_t v){
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+void grid_index_init(GridIndex& g, int w, int h, GridLayout layout){
+    g.layout = layout; g.width = w; g.height = h;
+    g.xs.resize(w); g.ys.resize(h);
+    switch(layout){
+    case GridLayout::RowMajor:
+        for(int x=0;x<w;++x) g.xs[x] = (uint32_t)x;
+        for(int y=0;y<h;++y) g.ys[y] = (uint32_t)y * w;
+        g.size = (size_t)w * h;
+        break;
+    case GridLayout::Block: {
+        const int B = 8, cols = (w + B - 1) / B, rows = (h + B - 1) / B;
+        for(int x=0;x<w;++x) g.xs[x] = (uint32_t)((x / B) * B*B + x % B);
+        for(int y=0;y<h;++y) g.ys[y] = (uint32_t)((y / B) * cols * B*B + (y % B) * B);
+        g.size = (size_t)cols * rows * B*B;
+        break; }
+    case GridLayout::Morton: {
+        const int T = 16, cols = (w + T - 1) / T, rows = (h + T - 1) / T;
+        for(int x=0;x<w;++x) g.xs[x] = (uint32_t)((x / T) * T*T) + spread_bits(x % T);
+        for(int y=0;y<h;++y) g.ys[y] = (uint32_t)((y / T) * cols * T*T) + (spread_bits(y % T) << 1);
+        g.size = (size_t)cols * rows * T*T;
+        break; }
+    }
+}
+
+const char* grid_layout_name(GridLayout l){
+    return l==GridLayout::Block ? "block" : l==GridLayout::Morton ? "morton" : "rowmajor";
+}
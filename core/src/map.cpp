@@ -0,0 +1,52 @@
+#include "sim.hpp"
+#include <atomic>
+
+static inline uint8_t walkable_at(const Map& m, size_t i){ return m.tiles[i]!=1 && !m.blocked[i]; }
+
+// Verze jsou unikátní napříč všemi Sim v procesu, takže shoda verze bloku
+// znamená shodný obsah i při obnově snapshotu jiné instance.
+static std::atomic<uint32_t> g_chunk_version{0};
+
+uint32_t map_next_version(){ return g_chunk_version.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+void map_touch(Map& m, int i, uint8_t layers){
+    if((layers & (kLayerTiles | kLayerBlocked)) && m.walk.size()==m.walk_ix.size && m.walk_ix.width==m.width && m.walk_ix.height==m.height)
+        m.walk[m.walk_ix(i % m.width, i / m.width)] = walkable_at(m, (size_t)i);
+    if(m.chunk_ver.empty()) return; // verze se zavedou až map_touch_all()
+    int cx = (i % m.width) / kMapChunk, cy = (i / m.width) / kMapChunk;
+    if(cx >= m.chunk_cols || cy >= m.chunk_rows) return;
+    const size_t c = (size_t)cy * m.chunk_cols + cx;
+    const uint32_t v = map_next_version();
+    m.chunk_ver[c] = v;
+    for(int L=0;L<kMapLayers;++L) if(layers & (1u<<L)) m.layer_ver[L][c] = v;
+    m.journal.push_back(MapChange{ i, layers });
+}
+
+void map_touch_all(Map& m){
+    m.chunk_cols = (m.width + kMapChunk - 1) / kMapChunk;
+    m.chunk_rows = (m.height + kMapChunk - 1) / kMapChunk;
+    const size_t n = (size_t)m.chunk_cols * m.chunk_rows;
+    m.chunk_ver.resize(n);
+    for(auto& lv: m.layer_ver) lv.resize(n);
+    for(size_t c=0;c<n;++c){
+        uint32_t v = map_next_version();
+        m.chunk_ver[c] = v;
+        for(auto& lv: m.layer_ver) lv[c] = v;
+    }
+    map_set_layout(m, m.walk_ix.layout);
+    m.journal.clear(); // vše změněno – dílčí záznamy ztrácí smysl
+    m.journal.push_back(MapChange{ -1, kLayerAll });
+}
+
+void map_set_layout(Map& m, GridLayout l){
+    grid_index_init(m.walk_ix, m.width, m.height, l);
+    m.walk.assign(m.walk_ix.size, 0); // zarovnání mimo mapu = neprůchodné
+    if(m.tiles.size()!=(size_t)m.width*m.height || m.blocked.size()!=m.tiles.size()) return;
+    map_refresh_walk(m, 0, 0, m.width, m.height);
+}
+
+void map_refresh_walk(Map& m, int x0, int y0, int w, int h){
+    if(m.walk.size()!=m.walk_ix.size || m.walk_ix.width!=m.width || m.walk_ix.height!=m.height) return;
+    for(int y=y0;y<y0+h;++y) for(int x=x0;x<x0+w;++x)
+        m.walk[m.walk_ix(x,y)] = walkable_at(m, (size_t)y*m.width + x);
+}
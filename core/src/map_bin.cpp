@@ -0,0 +1,120 @@
+#include "data.hpp"
+#include "sim.hpp"
+#include "savegame.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+
+static const char kMapMagic[4] = { 'R','T','S','M' };
+static const size_t kMapHeader = 44;
+
+namespace {
+struct Out{
+    std::vector<uint8_t> b;
+    void u8(uint8_t v){ b.push_back(v); }
+    void u32(uint32_t v){ for(int k=0;k<4;++k) u8((uint8_t)(v>>(8*k))); }
+    void i32(int32_t v){ u32((uint32_t)v); }
+    void u64(uint64_t v){ u32((uint32_t)v); u32((uint32_t)(v>>32)); }
+    void varint(uint32_t v){ while(v >= 0x80){ u8((uint8_t)(v | 0x80)); v >>= 7; } u8((uint8_t)v); }
+};
+struct In{
+    const uint8_t* p; const uint8_t* end; bool ok=true;
+    bool need(size_t n){ if((size_t)(end-p) < n) ok=false; return ok; }
+    uint8_t u8(){ return need(1) ? *p++ : 0; }
+    uint32_t u32(){ if(!need(4)) return 0; uint32_t v = (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24; p+=4; return v; }
+    int32_t i32(){ return (int32_t)u32(); }
+    uint64_t u64(){ uint64_t lo = u32(); return lo | (uint64_t)u32()<<32; }
+    uint32_t varint(){
+        uint32_t v=0;
+        for(int sh=0; sh<35; sh+=7){ uint8_t c=u8(); if(!ok) return 0; v |= (uint32_t)(c & 0x7F) << sh; if(!(c & 0x80)) return v; }
+        ok=false; return 0;
+    }
+};
+}
+
+bool save_map_bin(const Map& m, const std::string& path, int wood_amount, int gold_amount, const MapSource& source){
+    const size_t n = (size_t)m.width * m.height;
+    if(m.width<=0 || m.height<=0 || m.tiles.size()!=n) return false;
+    Out d;
+    size_t drops=0; for(uint8_t t: m.tiles) drops += t==4;
+    d.u32((uint32_t)drops);
+    for(int y=0;y<m.height;++y) for(int x=0;x<m.width;++x) if(m.tiles[(size_t)y*m.width + x]==4){ d.i32(x); d.i32(y); }
+    d.u32(2);
+    d.u8(3); d.u8((uint8_t)ResourceKind::Wood); d.i32(wood_amount);
+    d.u8(2); d.u8((uint8_t)ResourceKind::Gold); d.i32(gold_amount);
+    Out runs; uint32_t nruns=0;
+    for(size_t i=0;i<n;){
+        size_t j=i+1; while(j<n && m.tiles[j]==m.tiles[i] && j-i < 0xFFFFFFFFu) ++j;
+        runs.u8(m.tiles[i]); runs.varint((uint32_t)(j-i)); ++nruns;
+        i=j;
+    }
+    d.u32(nruns); d.b.insert(d.b.end(), runs.b.begin(), runs.b.end());
+
+    Out f; f.b.reserve(kMapHeader + d.b.size());
+    f.b.insert(f.b.end(), kMapMagic, kMapMagic+4);
+    f.u32(kMapBinVersion); f.i32(m.width); f.i32(m.height);
+    f.u32((uint32_t)d.b.size()); f.u32(crc32(d.b.data(), d.b.size()));
+    f.u64(source.size); f.u64((uint64_t)source.mtime); f.u32(source.crc);
+    f.b.insert(f.b.end(), d.b.begin(), d.b.end());
+    return write_file_atomic(path, f.b.data(), f.b.size());
+}
+
+static bool file_crc32(const std::string& path, uint32_t* out){
+    MappedFile mf;
+    if(!mapped_open(mf, path)) return false;
+    *out = crc32(mf.data, mf.size);
+    return true;
+}
+
+bool map_source_of(const std::string& path, MapSource* out){
+    return file_stat(path, &out->size, &out->mtime) && file_crc32(path, &out->crc);
+}
+
+// map.txt se čte celý jen když sedí velikost a ne čas (CRC32 16 MB mapy ~ desítky ms)
+static bool source_current(const MapSource& built, const std::string& path){
+    MapSource cur;
+    if(!file_stat(path, &cur.size, &cur.mtime)) return true; // zdroj chybí – není proti čemu zastarat
+    if(cur.size!=built.size) return false;
+    if(cur.mtime==built.mtime) return true;
+    return file_crc32(path, &cur.crc) && cur.crc==built.crc;
+}
+
+bool load_map_bin(const std::string& path, Map& out, std::vector<Vec2i>& dropoffs, const std::string* source_path){
+    MappedFile mf;
+    if(!mapped_open(mf, path) || mf.size < kMapHeader || std::memcmp(mf.data, kMapMagic, 4)!=0) return false;
+    In h{mf.data + 4, mf.data + kMapHeader};
+    const uint32_t ver = h.u32(); const int w = h.i32(), hgt = h.i32(); const uint32_t len = h.u32(), crc = h.u32();
+    MapSource src; src.size = h.u64(); src.mtime = (int64_t)h.u64(); src.crc = h.u32();
+    if(ver!=kMapBinVersion || w<=0 || hgt<=0 || (uint64_t)w*hgt > 0x7FFFFFFFu) return false;
+    if(source_path && !source_current(src, *source_path)) return false;
+    if(len > mf.size - kMapHeader || crc32(mf.data + kMapHeader, len)!=crc) return false;
+    In r{mf.data + kMapHeader, mf.data + kMapHeader + len};
+    const size_t n = (size_t)w * hgt;
+
+    const uint32_t nd = r.u32();
+    if(nd > n) return false;
+    std::vector<Vec2i> drops(nd);
+    for(auto& d: drops){ d.x = r.i32(); d.y = r.i32(); if(d.x<0 || d.y<0 || d.x>=w || d.y>=hgt) r.ok=false; }
+
+    uint8_t kind[256]={}; int amount[256]={};
+    for(uint32_t k=0, nr=r.u32(); k<nr && r.ok; ++k){ uint8_t t=r.u8(); kind[t]=r.u8(); amount[t]=r.i32(); }
+
+    // jen přidávání za konec – každá stránka se zapíše jednou (žádné nulování předem)
+    std::vector<uint8_t> tiles, res_kind; std::vector<int> res_amount, res_max;
+    tiles.reserve(n); res_kind.reserve(n); res_amount.reserve(n); res_max.reserve(n);
+    size_t i=0;
+    for(uint32_t k=0, nr=r.u32(); k<nr && r.ok; ++k){
+        const uint8_t t = r.u8(); const uint32_t run = r.varint();
+        if(!r.ok || run > n-i){ r.ok=false; break; }
+        tiles.insert(tiles.end(), run, t);
+        res_kind.insert(res_kind.end(), run, kind[t]);
+        res_amount.insert(res_amount.end(), run, kind[t] ? amount[t] : 0);
+        res_max.insert(res_max.end(), run, kind[t] ? amount[t] : 0);
+        i += run;
+    }
+    if(!r.ok || i!=n) return false;
+    out.width=w; out.height=hgt;
+    out.tiles=std::move(tiles); out.blocked.assign(n, 0);
+    out.res_kind=std::move(res_kind); out.res_amount=std::move(res_amount); out.res_max=std::move(res_max);
+    dropoffs = std::move(drops);
+    return true;
+}
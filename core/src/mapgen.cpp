@@ -0,0 +1,78 @@
+#include "mapgen.hpp"
+#include "rng.hpp"
+#include <algorithm>
+
+// Zdi v mřížce po 'maze_cell', mezi buňkami se DFS (recursive backtracker)
+// probourá celá stěna; pak se náhodně otevřou ještě 'maze_loops' % stěn.
+static void carve_maze(Map& m, const MapGenParams& p, RNG& rng){
+    const int c = p.maze_cell, w = m.width, cols = (m.width-1)/c, rows = (m.height-1)/c;
+    if(cols<1 || rows<1) return;
+    auto tile = [&](int x, int y) -> uint8_t& { return m.tiles[(size_t)y*w + x]; };
+    // jen vnitřní zdi – okraj mapy a zbytek za poslední buňkou zůstanou průchozí (vše spojené)
+    for(int k=1;k<rows;++k) for(int x=0;x<=cols*c;++x) tile(x, k*c) = 1;
+    for(int k=1;k<cols;++k) for(int y=0;y<=rows*c;++y) tile(k*c, y) = 1;
+
+    std::vector<uint8_t> east((size_t)cols*rows, 0), south((size_t)cols*rows, 0), seen((size_t)cols*rows, 0);
+    auto open = [&](int cell, bool to_south){
+        const int cx = cell % cols, cy = cell / cols;
+        if(to_south){ south[cell]=1; for(int x=cx*c+1;x<(cx+1)*c;++x) tile(x, (cy+1)*c) = 0; }
+        else        { east[cell]=1;  for(int y=cy*c+1;y<(cy+1)*c;++y) tile((cx+1)*c, y) = 0; }
+    };
+    std::vector<int> stack{0}; seen[0]=1;
+    while(!stack.empty()){
+        const int cell = stack.back(), cx = cell % cols, cy = cell / cols;
+        int next[4], n=0;
+        if(cx>0 && !seen[cell-1])         next[n++] = cell-1;
+        if(cx<cols-1 && !seen[cell+1])    next[n++] = cell+1;
+        if(cy>0 && !seen[cell-cols])      next[n++] = cell-cols;
+        if(cy<rows-1 && !seen[cell+cols]) next[n++] = cell+cols;
+        if(!n){ stack.pop_back(); continue; }
+        const int to = next[rng.next_range((uint32_t)n)];
+        const int lo = std::min(cell, to);
+        open(lo, to - cell == cols || cell - to == cols);
+        seen[to]=1; stack.push_back(to);
+    }
+    if(p.maze_loops>0)
+        for(int cell=0; cell<cols*rows; ++cell){
+            if(cell % cols < cols-1 && !east[cell] && (int)rng.next_range(100) < p.maze_loops) open(cell, false);
+            if(cell / cols < rows-1 && !south[cell] && (int)rng.next_range(100) < p.maze_loops) open(cell, true);
+        }
+}
+
+bool mapgen_generate(Sim& s, const MapGenParams& p){
+    const int w = p.width, h = p.height;
+    if(w<=0 || h<=0 || w>kMapGenMaxSize || h>kMapGenMaxSize) return false;
+    Map& m = s.map;
+    m.width = w; m.height = h;
+    m.tiles.assign((size_t)w*h, 0);
+    m.blocked.assign((size_t)w*h, 0);
+    m.res_kind.clear(); m.res_amount.clear(); m.res_max.clear();
+    RNG rng(p.seed);
+
+    if(p.clump_area>0){
+        const int clumps = std::max(1, w*h / p.clump_area);
+        for(int c=0;c<clumps;++c){
+            int cx = (int)rng.next_range(w), cy = (int)rng.next_range(h), r = 1 + (int)rng.next_range((uint32_t)std::max(1, p.clump_radius));
+            uint8_t t = rng.next_range((uint32_t)std::max(1, p.gold_one_in))==0 ? 2 : 3; // zlato / les
+            for(int y=std::max(0,cy-r);y<=std::min(h-1,cy+r);++y)
+                for(int x=std::max(0,cx-r);x<=std::min(w-1,cx+r);++x) m.tiles[(size_t)y*w+x] = t;
+        }
+    }
+    if(p.maze_cell>=3) carve_maze(m, p, rng);
+
+    // sklady v mřížce gc x gr, kolem každého volno; sklad k patří hráči k % players
+    const int n = std::max(1, p.dropoffs);
+    int gc=1; while(gc*gc<n) ++gc;
+    const int gr = (n + gc - 1) / gc, cr = std::max(0, p.dropoff_clear);
+    std::vector<Vec2i> drops;
+    for(int k=0;k<n;++k) drops.push_back({ (2*(k%gc)+1)*w / (2*gc), (2*(k/gc)+1)*h / (2*gr) });
+    for(const auto& d: drops)
+        for(int y=std::max(0,d.y-cr);y<=std::min(h-1,d.y+cr);++y)
+            for(int x=std::max(0,d.x-cr);x<=std::min(w-1,d.x+cr);++x) m.tiles[(size_t)y*w+x] = 0;
+    for(auto& pl: s.players) pl.dropoffs.clear();
+    for(int k=0;k<n;++k){
+        m.tiles[(size_t)drops[k].y*w + drops[k].x] = 4;
+        s.players[k % s.players.size()].dropoffs.push_back(drops[k]);
+    }
+    return true;
+}
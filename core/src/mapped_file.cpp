@@ -0,0 +1,123 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #include <windows.h>
+  #include <cstdio>
+  #include <io.h>
+#else
+  #include <cerrno>
+  #include <cstdio>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile(){ mapped_close(*this); }
+
+#ifdef _WIN32
+bool mapped_open(MappedFile& f, const std::string& path){
+    mapped_close(f);
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(h==INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz{};
+    if(!GetFileSizeEx(h, &sz)){ CloseHandle(h); return false; }
+    f.file = h;
+    if(sz.QuadPart==0) return true;
+    HANDLE m = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!m){ mapped_close(f); return false; }
+    f.mapping = m;
+    f.data = (const uint8_t*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if(!f.data){ mapped_close(f); return false; }
+    f.size = (size_t)sz.QuadPart;
+    return true;
+}
+
+void mapped_close(MappedFile& f){
+    if(f.data) UnmapViewOfFile(f.data);
+    if(f.mapping) CloseHandle((HANDLE)f.mapping);
+    if(f.file) CloseHandle((HANDLE)f.file);
+    f.data=nullptr; f.size=0; f.mapping=nullptr; f.file=nullptr;
+}
+
+bool file_stat(const std::string& path, uint64_t* size, int64_t* mtime){
+    WIN32_FILE_ATTRIBUTE_DATA a{};
+    if(!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &a)) return false;
+    *size = (uint64_t)a.nFileSizeHigh << 32 | a.nFileSizeLow;
+    *mtime = (int64_t)((uint64_t)a.ftLastWriteTime.dwHighDateTime << 32 | a.ftLastWriteTime.dwLowDateTime);
+    return true;
+}
+
+bool write_file_atomic(const std::string& path, const uint8_t* data, size_t size){
+    const std::string tmp = path + ".tmp";
+    FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if(!fp) return false;
+    bool ok = (size==0 || std::fwrite(data, 1, size, fp)==size) && std::fflush(fp)==0 && _commit(_fileno(fp))==0;
+    ok = std::fclose(fp)==0 && ok;
+    if(ok) ok = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)!=0;
+    if(!ok) std::remove(tmp.c_str());
+    return ok;
+}
+#else
+bool mapped_open(MappedFile& f, const std::string& path){
+    mapped_close(f);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd<0) return false;
+    struct stat st{};
+    if(fstat(fd, &st)!=0){ ::close(fd); return false; }
+    f.fd = fd;
+    if(st.st_size==0) return true;
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(p==MAP_FAILED){ mapped_close(f); return false; }
+    f.data = (const uint8_t*)p; f.size = (size_t)st.st_size;
+    return true;
+}
+
+void mapped_close(MappedFile& f){
+    if(f.data) munmap((void*)f.data, f.size);
+    if(f.fd>=0) ::close(f.fd);
+    f.data=nullptr; f.size=0; f.fd=-1;
+}
+
+bool file_stat(const std::string& path, uint64_t* size, int64_t* mtime){
+    struct stat st{};
+    if(::stat(path.c_str(), &st)!=0) return false;
+    *size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+    *mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+// rename je trvalý až po fsync adresáře (jinak ho výpadek napájení může vrátit);
+// EINVAL = souborový systém fsync adresáře nepodporuje
+static bool fsync_parent_dir(const std::string& path){
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash==std::string::npos ? "." : slash==0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if(fd<0) return false;
+    bool ok = ::fsync(fd)==0 || errno==EINVAL;
+    ::close(fd);
+    return ok;
+}
+
+bool write_file_atomic(const std::string& path, const uint8_t* data, size_t size){
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd<0) return false;
+    bool ok = true;
+    for(size_t at=0; ok && at<size;){
+        ssize_t n = ::write(fd, data + at, size - at);
+        if(n<0 && errno==EINTR) continue;
+        if(n<=0) ok = false; else at += (size_t)n;
+    }
+    ok = ok && ::fsync(fd)==0;
+    ok = ::close(fd)==0 && ok;
+    if(ok) ok = std::rename(tmp.c_str(), path.c_str())==0;
+    if(!ok){ std::remove(tmp.c_str()); return false; }
+    return fsync_parent_dir(path);
+}
+#endif
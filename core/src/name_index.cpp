@@ -0,0 +1,64 @@
+#include "name_index.hpp"
+#include <algorithm>
+
+static uint32_t mix32(uint32_t h){ h ^= h >> 16; h *= 0x85EBCA6Bu; h ^= h >> 13; h *= 0xC2B2AE35u; h ^= h >> 16; return h; }
+static uint32_t name_hash(std::string_view s, uint32_t salt){
+    uint32_t h = 2166136261u ^ salt; // FNV-1a
+    for(unsigned char c: s){ h ^= c; h *= 16777619u; }
+    return mix32(h);
+}
+
+uint16_t NameIndex::find(std::string_view s) const {
+    if(slots.empty()) return kNone;
+    const uint32_t h = name_hash(s, salt);
+    const uint16_t i = slots[mix32(h ^ seeds[h % seeds.size()]) % slots.size()];
+    return i!=kNone && names[i]==s ? i : kNone;
+}
+
+bool name_index_build(NameIndex& ix, const std::vector<std::string>& names){
+    const size_t n = names.size();
+    ix = NameIndex{};
+    if(n >= NameIndex::kNone) return false;
+    ix.names = names;
+    if(n==0) return true;
+    const size_t nb = (n + 1) / 2, m = n + n/4 + 1; // ~2 jména na koš, 80% zaplnění slotů
+    std::vector<uint32_t> h(n);
+    std::vector<std::vector<uint32_t>> buckets(nb);
+    std::vector<uint32_t> order(nb), slot_of;
+    for(uint32_t salt=0; salt<64; ++salt){
+        for(size_t i=0;i<n;++i) h[i] = name_hash(names[i], salt);
+        std::vector<uint32_t> sorted(h); std::sort(sorted.begin(), sorted.end());
+        if(std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()){
+            // stejný hash = duplicitní jméno (nebo vzácná 32bit kolize -> jiný salt)
+            for(size_t i=0;i<n;++i) for(size_t k=i+1;k<n;++k) if(h[i]==h[k] && names[i]==names[k]) return false;
+            continue;
+        }
+        for(auto& b: buckets) b.clear();
+        for(uint32_t i=0;i<n;++i) buckets[h[i] % nb].push_back(i);
+        for(uint32_t b=0;b<nb;++b) order[b]=b;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return buckets[a].size() > buckets[b].size(); });
+
+        ix.salt = salt; ix.seeds.assign(nb, 0); ix.slots.assign(m, NameIndex::kNone);
+        bool ok = true;
+        for(uint32_t b: order){ // největší koše první, každému se hledá posun bez kolize
+            const auto& keys = buckets[b];
+            if(keys.empty()) break;
+            uint32_t seed = 0;
+            for(; seed < (1u<<20); ++seed){
+                slot_of.clear();
+                for(uint32_t k: keys){
+                    const uint32_t sl = mix32(h[k] ^ seed) % (uint32_t)m;
+                    if(ix.slots[sl]!=NameIndex::kNone || std::find(slot_of.begin(), slot_of.end(), sl)!=slot_of.end()) break;
+                    slot_of.push_back(sl);
+                }
+                if(slot_of.size()==keys.size()) break;
+            }
+            if(seed == (1u<<20)){ ok=false; break; }
+            ix.seeds[b] = seed;
+            for(size_t k=0;k<keys.size();++k) ix.slots[slot_of[k]] = (uint16_t)keys[k];
+        }
+        if(ok) return true;
+    }
+    ix = NameIndex{};
+    return false;
+}
@@ -1,61 +1,87 @@
-
 #include "pathfinding.hpp"
 #include "sim.hpp"
+#include "prof.hpp"
 #include <queue>
 #include <vector>
 #include <limits>
 #include <cmath>
 #include <algorithm>
 
-static inline int idx(int w,int x,int y){ return y*w+x; }
 static inline int hcost(Vec2i a, Vec2i b){ int dx=std::abs(a.x-b.x), dy=std::abs(a.y-b.y); return (dx+dy)*10; }
 
-bool astar_find(const Map& map, Vec2i start, Vec2i goal, std::vector<Vec2i>& out_path, bool diag, int max_nodes){
+// Pracovní pole A* ve stejném rozložení jako Map::walk; platnost po prvcích
+// přes 'stamp' (žádné nulování W*H při každém hledání).
+struct AstarScratch{
+    GridIndex ix;
+    std::vector<uint8_t> walk; // jen když mapa nemá Map::walk (bez map_touch_all)
+    std::vector<int> g;
+    std::vector<uint32_t> stamp;
+    std::vector<uint8_t> dir;  // směr, kterým se do dlaždice přišlo (rekonstrukce cesty)
+    uint32_t cur=0;
+};
+static thread_local AstarScratch t_scratch;
+
+bool astar_find(const Map& map, Vec2i start, Vec2i goal, std::vector<Vec2i>& out_path, bool diag, int max_nodes,
+                const std::vector<uint16_t>* occupancy, int occupancy_radius){
+    RTS_PROF_SCOPE("astar_find");
     if(start.x==goal.x && start.y==goal.y){ out_path.clear(); return true; }
     const int W=map.width, H=map.height;
-    std::vector<int> g(W*H, std::numeric_limits<int>::max());
-    std::vector<int> parent(W*H, -1);
+    // cíl z příkazu / replaye může ležet mimo mapu – ix() ani stamp[] se mimo mapu číst nesmí
+    if(start.x<0||start.y<0||start.x>=W||start.y>=H || goal.x<0||goal.y<0||goal.x>=W||goal.y>=H) return false;
+    AstarScratch& S = t_scratch;
+    const bool has_walk = map.walk.size()==map.walk_ix.size && map.walk_ix.width==W && map.walk_ix.height==H;
+    const GridIndex& ix = has_walk ? map.walk_ix : S.ix;
+    if(!has_walk){
+        if(S.ix.width!=W || S.ix.height!=H || S.ix.layout!=GridLayout::RowMajor) grid_index_init(S.ix, W, H, GridLayout::RowMajor);
+        S.walk.resize((size_t)W*H);
+        for(size_t i=0;i<S.walk.size();++i) S.walk[i] = map.tiles[i]!=1 && !map.blocked[i];
+    }
+    const uint8_t* walk = has_walk ? map.walk.data() : S.walk.data();
+    if(S.g.size() < ix.size){ S.g.resize(ix.size); S.stamp.assign(ix.size, 0); S.dir.resize(ix.size); S.cur=0; }
+    if(++S.cur==0){ std::fill(S.stamp.begin(), S.stamp.end(), 0); S.cur=1; }
+    const uint32_t cur = S.cur;
+    int* g = S.g.data(); uint32_t* stamp = S.stamp.data(); uint8_t* dir = S.dir.data();
+
     struct Node{ int f,x,y; };
     auto cmp=[](const Node& a,const Node& b){ return a.f>b.f; };
     std::priority_queue<Node,std::vector<Node>,decltype(cmp)> open(cmp);
-    int sidx=idx(W,start.x,start.y), gidx=idx(W,goal.x,goal.y);
-    g[sidx]=0; open.push({hcost(start,goal), start.x, start.y});
+    const uint32_t sidx=ix(start.x,start.y), gidx=ix(goal.x,goal.y);
+    g[sidx]=0; stamp[sidx]=cur; open.push({hcost(start,goal), start.x, start.y});
     int processed=0;
     auto is_block=[&](int x,int y){
         if(x<0||y<0||x>=W||y>=H) return true;
-        uint8_t t = map.tiles[idx(W,x,y)];
-        if(map.blocked[idx(W,x,y)]) return true;
-        return t==1; // walls block only
+        if(!walk[ix(x,y)]) return true; // walls + blocked
+        return occupancy && std::abs(x-start.x)<=occupancy_radius && std::abs(y-start.y)<=occupancy_radius
+            && (*occupancy)[ridx(map,x,y)] && !(x==goal.x && y==goal.y);
     };
-    const int dirs8[8][2]={{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
-    const int dirs4[4][2]={{1,0},{-1,0},{0,1},{0,-1}};
-    auto dirs = diag?dirs8:dirs4;
+    static const int dirs8[8][2]={{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
     int dcount = diag?8:4;
     while(!open.empty()){
         Node n = open.top(); open.pop();
         if(++processed>max_nodes) break;
         if(n.x==goal.x && n.y==goal.y) break;
-        int ni = idx(W,n.x,n.y);
+        const uint32_t ni = ix(n.x,n.y);
         for(int i=0;i<dcount;++i){
-            int nx=n.x+dirs[i][0], ny=n.y+dirs[i][1];
+            int nx=n.x+dirs8[i][0], ny=n.y+dirs8[i][1];
             if(is_block(nx,ny)) continue;
             int cost = g[ni] + ((i<4)?10:14);
-            int nidx = idx(W,nx,ny);
-            if(cost < g[nidx]){
+            const uint32_t nidx = ix(nx,ny);
+            if(stamp[nidx]!=cur || cost < g[nidx]){
+                stamp[nidx]=cur;
                 g[nidx]=cost;
-                parent[nidx]=ni;
+                dir[nidx]=(uint8_t)i;
                 int f = cost + hcost({nx,ny}, goal);
                 open.push({f,nx,ny});
             }
         }
     }
-    if(parent[gidx]==-1) return false;
+    if(stamp[gidx]!=cur) return false;
     out_path.clear();
-    int cur=gidx;
-    while(cur!=sidx && cur!=-1){
-        int y=cur/W, x=cur%W;
-        out_path.push_back({x,y});
-        cur=parent[cur];
+    Vec2i c = goal;
+    while(!(c.x==start.x && c.y==start.y)){
+        out_path.push_back(c);
+        int d = dir[ix(c.x,c.y)];
+        c.x -= dirs8[d][0]; c.y -= dirs8[d][1];
     }
     std::reverse(out_path.begin(), out_path.end());
     return true;
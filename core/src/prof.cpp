@@ -0,0 +1,60 @@
+#include "prof.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace {
+constexpr uint32_t kRingSize = 1u << 16; // mocnina dvou
+
+struct ProfEvent{ const char* name; uint64_t t0, t1; uint32_t tid; };
+
+ProfEvent g_ring[kRingSize];
+std::atomic<uint64_t> g_head{0};
+const auto g_epoch = std::chrono::steady_clock::now();
+
+uint32_t thread_tag(){
+    static thread_local uint32_t tag = (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return tag;
+}
+}
+
+uint64_t prof_now_ns(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void prof_record(const char* name, uint64_t t0_ns, uint64_t t1_ns){
+    uint64_t i = g_head.fetch_add(1, std::memory_order_relaxed);
+    g_ring[i & (kRingSize-1)] = ProfEvent{ name, t0_ns, t1_ns, thread_tag() };
+}
+
+void prof_clear(){ g_head.store(0, std::memory_order_relaxed); }
+
+bool prof_enabled(){
+#ifdef RTS_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Dump neblokuje zapisovatele; událost přepsaná během dumpu se může objevit
+// ve výstupu zkreslená, pro ladicí trace je to přijatelné.
+bool prof_dump_chrome(const std::string& path){
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if(!f) return false;
+    const uint64_t head = g_head.load(std::memory_order_acquire);
+    const uint64_t first = head > kRingSize ? head - kRingSize : 0;
+    std::fputs("{\"traceEvents\":[\n", f);
+    bool comma = false;
+    for(uint64_t i=first; i<head; ++i){
+        const ProfEvent e = g_ring[i & (kRingSize-1)];
+        if(!e.name) continue;
+        std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            comma ? ",\n" : "", e.name, e.tid, e.t0/1000.0, (e.t1 - e.t0)/1000.0);
+        comma = true;
+    }
+    std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+    return std::fclose(f)==0;
+}
@@ -0,0 +1,522 @@
+#include "savegame.hpp"
+#include "mapped_file.hpp"
+#include "state_hash.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+static const char kMagic[4] = { 'R','T','S','B' };
+static const size_t kHeader = 16, kDirEntry = 24;
+
+static constexpr uint32_t fourcc(const char (&t)[5]){
+    return (uint32_t)(uint8_t)t[0] | (uint32_t)(uint8_t)t[1]<<8 | (uint32_t)(uint8_t)t[2]<<16 | (uint32_t)(uint8_t)t[3]<<24;
+}
+static constexpr uint32_t kMeta=fourcc("META"), kTiles=fourcc("TILE"), kBlocked=fourcc("BLCK"),
+    kResKind=fourcc("RKND"), kResAmount=fourcc("RAMT"), kResMax=fourcc("RMAX"), kDrops=fourcc("DROP"),
+    kTypes=fourcc("TYPE"), kBuildings=fourcc("BLDG"), kUnits=fourcc("UNIT"),
+    kPlayers=fourcc("PLYR"), kUnitCombat=fourcc("UCMB"), kBuildTimers=fourcc("BTIM"), kKeyframe=fourcc("KEYF"), kBase=fourcc("BASE"), kPatch=fourcc("PTCH"),
+    kUnitDelta=fourcc("UDLT"), kBuildingDelta=fourcc("BDLT");
+
+uint32_t crc32(const uint8_t* p, size_t n){
+    static uint32_t table[256];
+    static bool init = [](){
+        for(uint32_t i=0;i<256;++i){ uint32_t c=i; for(int k=0;k<8;++k) c = (c&1) ? 0xEDB88320u ^ (c>>1) : c>>1; table[i]=c; }
+        return true;
+    }();
+    (void)init;
+    uint32_t c = 0xFFFFFFFFu;
+    for(size_t i=0;i<n;++i) c = table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static bool host_le(){ const uint16_t v=1; uint8_t b; std::memcpy(&b, &v, 1); return b==1; }
+
+// --- zápis
+
+struct Out{
+    std::vector<uint8_t> b;
+    void u8(uint8_t v){ b.push_back(v); }
+    void u16(uint16_t v){ u8((uint8_t)v); u8((uint8_t)(v>>8)); }
+    void u32(uint32_t v){ for(int k=0;k<4;++k) u8((uint8_t)(v>>(8*k))); }
+    void u64(uint64_t v){ for(int k=0;k<8;++k) u8((uint8_t)(v>>(8*k))); }
+    void i32(int32_t v){ u32((uint32_t)v); }
+    void bytes(const uint8_t* p, size_t n){ b.insert(b.end(), p, p+n); }
+    void str(const std::string& s){ u16((uint16_t)s.size()); bytes((const uint8_t*)s.data(), s.size()); }
+    void ints(const int* p, size_t n){
+        if(host_le()){ size_t at=b.size(); b.resize(at + n*4); if(n) std::memcpy(&b[at], p, n*4); }
+        else for(size_t i=0;i<n;++i) i32(p[i]);
+    }
+};
+
+struct Section{ uint32_t tag; Out data; };
+using Sections = std::vector<Section>;
+
+static Out& add(Sections& secs, uint32_t tag){ secs.push_back(Section{ tag, {} }); return secs.back().data; }
+
+// záznamy entit: plný save je skládá po sekcích (BLDG+BTIM, UNIT+UCMB, vlastníci
+// v PLYR), delta a SaveKeyframe po entitách (put_*_record)
+static void put_building(Out& o, const Sim& s, const Building& b){
+    o.u32(b.id); o.u8((uint8_t)b.kind); o.u8((uint8_t)b.state);
+    o.i32(b.tile.x); o.i32(b.tile.y); o.i32(b.w); o.i32(b.h);
+    o.i32(building_progress_ms(s,b)); o.i32(b.build_total_ms);
+    o.i32(b.cost_gold); o.i32(b.cost_wood); o.i32(b.rally.x); o.i32(b.rally.y);
+    o.u32((uint32_t)b.queue.size());
+    for(size_t k=0;k<b.queue.size();++k){
+        o.u16(b.queue[k].unit_type);
+        o.i32(k==0 ? train_remaining_ms(s,b) : b.queue[k].remaining_ms);
+    }
+}
+static void put_building_timers(Out& o, const Building& b){ o.i32(b.build_progress_ms); o.u32(b.build_since_tick); o.i32(b.build_workers); o.u32(b.train_due_tick); }
+static void put_unit(Out& o, const Unit& u){
+    o.u32(u.id); o.u16(u.type_index);
+    o.i32(u.tile.x); o.i32(u.tile.y); o.i32(u.goal.x); o.i32(u.goal.y);
+    o.i32(u.hp); o.u8((uint8_t)u.job); o.i32(u.carried); o.u8(u.carried_kind);
+    o.u32(u.building_target); o.u8(u.owner);
+}
+static void put_unit_combat(Out& o, const Unit& u){ o.u16(u.cooldown); o.u32(u.target); }
+static void put_unit_record(Out& o, const Unit& u){ put_unit(o, u); put_unit_combat(o, u); }
+static void put_building_record(Out& o, const Sim& s, const Building& b){ put_building(o, s, b); put_building_timers(o, b); o.u8(b.owner); }
+
+template<class T, class Put>
+static void records_of(const std::vector<T>& v, SaveRecords& out, Put put){
+    Out r; out.at.clear(); out.at.reserve(v.size());
+    for(const auto& e: v){ const size_t at = r.b.size(); put(r, e); out.at[e.id] = { (uint32_t)at, (uint32_t)(r.b.size() - at) }; }
+    out.bytes.swap(r.b);
+}
+
+void save_keyframe_records(const Sim& s, SaveKeyframe& k){
+    records_of(s.units, k.units, put_unit_record);
+    records_of(s.buildings, k.buildings, [&](Out& o, const Building& b){ put_building_record(o, s, b); });
+}
+
+// u32 n, po entitách: u8 0 + u32 id (záznam shodný s keyframe), nebo u8 1 + celý záznam
+template<class T, class Put>
+static void put_delta(Out& o, const std::vector<T>& v, const SaveRecords& key, Put put){
+    o.u32((uint32_t)v.size());
+    Out r;
+    for(const auto& e: v){
+        r.b.clear(); put(r, e);
+        auto it = key.at.find(e.id);
+        if(it!=key.at.end() && it->second.second==r.b.size() && std::memcmp(&key.bytes[it->second.first], r.b.data(), r.b.size())==0){ o.u8(0); o.u32(e.id); }
+        else { o.u8(1); o.bytes(r.b.data(), r.b.size()); }
+    }
+}
+
+// vše kromě vrstev mapy; s 'key' entity jen jako delta proti keyframe
+static void encode_state(const Sim& s, Sections& secs, const SaveKeyframe* key=nullptr){
+    const Player& p0 = s.players[0];
+    { Out& o = add(secs, kMeta);
+      o.u32(s.tick); o.i32(p0.gold); o.i32(p0.wood); o.i32(p0.food_used); o.i32(p0.food_cap);
+      o.u32(s.next_unit_id); o.u32(s.next_building_id); o.i32(s.map.width); o.i32(s.map.height); }
+    { Out& o = add(secs, kDrops);
+      o.u32((uint32_t)p0.dropoffs.size());
+      for(auto d: p0.dropoffs){ o.i32(d.x); o.i32(d.y); } }
+    // typy jednotek podle id (indexy se mezi verzemi units.csv mohou lišit)
+    { Out& o = add(secs, kTypes);
+      o.u32((uint32_t)s.unit_types.size());
+      for(const auto& t: s.unit_types) o.str(t.id); }
+    if(key){
+        put_delta(add(secs, kBuildingDelta), s.buildings, key->buildings, [&](Out& o, const Building& b){ put_building_record(o, s, b); });
+        put_delta(add(secs, kUnitDelta), s.units, key->units, put_unit_record);
+    }else{
+        { Out& o = add(secs, kBuildings);
+          o.u32((uint32_t)s.buildings.size());
+          for(const auto& b: s.buildings) put_building(o, s, b); }
+        { Out& o = add(secs, kUnits);
+          o.u32((uint32_t)s.units.size());
+          for(const auto& u: s.units) put_unit(o, u); }
+        // časování budov beze změny (BLDG má progress/zbytek výcviku přepočtené k s.tick);
+        // load s ním dá stejný state_hash
+        { Out& o = add(secs, kBuildTimers);
+          o.u32((uint32_t)s.buildings.size());
+          for(const auto& b: s.buildings) put_building_timers(o, b); }
+        // cooldown a cíl boje (součást state_hash); starší savy bez UCMB = 0
+        { Out& o = add(secs, kUnitCombat);
+          o.u32((uint32_t)s.units.size());
+          for(const auto& u: s.units) put_unit_combat(o, u); }
+    }
+    // hráči 1.. a vlastníci budov; hráč 0 zůstává v META/DROP (starší savy mají jen jeho)
+    { Out& o = add(secs, kPlayers);
+      o.u32((uint32_t)s.players.size());
+      for(size_t p=1;p<s.players.size();++p){
+          const Player& pl = s.players[p];
+          o.i32(pl.gold); o.i32(pl.wood); o.i32(pl.food_used); o.i32(pl.food_cap);
+          o.u32((uint32_t)pl.dropoffs.size());
+          for(auto d: pl.dropoffs){ o.i32(d.x); o.i32(d.y); }
+      }
+      o.u32(key ? 0u : (uint32_t)s.buildings.size()); // delta má vlastníka v BDLT
+      if(!key) for(const auto& b: s.buildings) o.u8(b.owner); }
+}
+
+static void encode_layers(const Map& m, Sections& secs){
+    add(secs, kTiles).bytes(m.tiles.data(), m.tiles.size());
+    add(secs, kBlocked).bytes(m.blocked.data(), m.blocked.size());
+    add(secs, kResKind).bytes(m.res_kind.data(), m.res_kind.size());
+    add(secs, kResAmount).ints(m.res_amount.data(), m.res_amount.size());
+    add(secs, kResMax).ints(m.res_max.data(), m.res_max.size());
+}
+
+// rozvržení: hlavička, adresář, sekce zarovnané na 8 B
+static void finish(const Sections& secs, std::vector<uint8_t>& out){
+    size_t at = kHeader + kDirEntry*secs.size();
+    std::vector<uint64_t> offs;
+    for(const auto& sec: secs){ at = (at + 7) & ~(size_t)7; offs.push_back(at); at += sec.data.b.size(); }
+
+    Out dir;
+    for(size_t i=0;i<secs.size();++i){
+        const auto& d = secs[i].data.b;
+        dir.u32(secs[i].tag); dir.u32(crc32(d.data(), d.size())); dir.u64(offs[i]); dir.u64(d.size());
+    }
+    Out o; o.b.reserve(at);
+    o.bytes((const uint8_t*)kMagic, 4); o.u32(kSaveVersion); o.u32((uint32_t)secs.size()); o.u32(crc32(dir.b.data(), dir.b.size()));
+    o.bytes(dir.b.data(), dir.b.size());
+    for(size_t i=0;i<secs.size();++i){
+        o.b.resize(offs[i], 0);
+        o.bytes(secs[i].data.b.data(), secs[i].data.b.size());
+    }
+    out.swap(o.b);
+}
+
+void save_encode(const Sim& s, std::vector<uint8_t>& out, uint64_t key_id){
+    Sections secs;
+    encode_state(s, secs);
+    encode_layers(s.map, secs);
+    if(key_id) add(secs, kKeyframe).u64(key_id);
+    finish(secs, out);
+}
+
+// blok mapy 'c' (mřížka kMapChunk) jako obdélník dlaždic
+static void chunk_rect(const Map& m, int c, int& x0, int& y0, int& w, int& h){
+    int cols = (m.width + kMapChunk - 1) / kMapChunk;
+    x0 = (c % cols) * kMapChunk; y0 = (c / cols) * kMapChunk;
+    w = std::min(kMapChunk, m.width - x0); h = std::min(kMapChunk, m.height - y0);
+}
+
+size_t save_encode_delta(const Sim& s, const SaveKeyframe& key, std::vector<uint8_t>& out){
+    const Map& m = s.map;
+    Sections secs;
+    encode_state(s, secs, &key);
+    { Out& o = add(secs, kBase); o.u64(key.id); o.str(key.file); }
+    Out& o = add(secs, kPatch);
+    o.u32(kMapChunk);
+    size_t count_at = o.b.size(); o.u32(0);
+    uint32_t n = 0;
+    for(size_t c=0;c<m.chunk_ver.size();++c){
+        if(c < key.chunk_ver.size() && key.chunk_ver[c]==m.chunk_ver[c]) continue; // beze změny od keyframe
+        int x0, y0, w, h; chunk_rect(m, (int)c, x0, y0, w, h);
+        o.u32((uint32_t)c);
+        for(int y=y0;y<y0+h;++y) o.bytes(&m.tiles[(size_t)y*m.width + x0], w);
+        for(int y=y0;y<y0+h;++y) o.bytes(&m.blocked[(size_t)y*m.width + x0], w);
+        for(int y=y0;y<y0+h;++y) o.bytes(&m.res_kind[(size_t)y*m.width + x0], w);
+        for(int y=y0;y<y0+h;++y) o.ints(&m.res_amount[(size_t)y*m.width + x0], w);
+        for(int y=y0;y<y0+h;++y) o.ints(&m.res_max[(size_t)y*m.width + x0], w);
+        ++n;
+    }
+    for(int k=0;k<4;++k) o.b[count_at+k] = (uint8_t)(n >> (8*k));
+    finish(secs, out);
+    return n;
+}
+
+// --- čtení
+
+struct In{
+    const uint8_t* p; size_t n, at=0; bool ok=true;
+    In(const uint8_t* p_, size_t n_) : p(p_), n(n_) {}
+    bool need(size_t k){ if(!ok || n-at < k){ ok=false; return false; } return true; }
+    uint8_t u8(){ return need(1) ? p[at++] : 0; }
+    uint16_t u16(){ if(!need(2)) return 0; uint16_t v = (uint16_t)(p[at] | p[at+1]<<8); at+=2; return v; }
+    uint32_t u32(){ if(!need(4)) return 0; uint32_t v=0; for(int k=0;k<4;++k) v |= (uint32_t)p[at+k]<<(8*k); at+=4; return v; }
+    uint64_t u64(){ uint64_t lo=u32(); return lo | (uint64_t)u32()<<32; }
+    int32_t i32(){ return (int32_t)u32(); }
+    std::string str(){ size_t len=u16(); if(!need(len)) return {}; std::string s((const char*)p+at, len); at+=len; return s; }
+    void ints(int* dst, size_t k){
+        if(!need(k*4)) return;
+        if(host_le()){ if(k) std::memcpy(dst, p+at, k*4); at += k*4; }
+        else for(size_t i=0;i<k;++i) dst[i] = i32();
+    }
+    // počet prvků z dat – odmítne víc, než může zbytek sekce obsahovat
+    uint32_t count(size_t min_elem){ uint32_t c=u32(); if(ok && c > (n-at)/min_elem) ok=false; return ok ? c : 0; }
+};
+
+struct Ref{ uint32_t tag; const uint8_t* p; size_t n; };
+
+static const Ref* find(const std::vector<Ref>& dir, uint32_t tag){
+    for(const auto& r: dir) if(r.tag==tag) return &r;
+    return nullptr;
+}
+
+// hlavička + adresář + CRC všech sekcí
+static bool parse(const uint8_t* data, size_t size, std::vector<Ref>& dir){
+    if(!save_is_binary(data, size)) return false;
+    In h(data, size); h.at = 4;
+    uint32_t ver = h.u32(), nsec = h.u32(), dir_crc = h.u32();
+    if(ver != kSaveVersion || nsec > (size - kHeader)/kDirEntry) return false;
+    if(crc32(data + kHeader, nsec*kDirEntry) != dir_crc) return false;
+    for(uint32_t i=0;i<nsec;++i){
+        uint32_t tag = h.u32(), crc = h.u32(); uint64_t off = h.u64(), len = h.u64();
+        if(off > size || len > size - off) return false;
+        if(crc32(data + off, (size_t)len) != crc) return false;
+        dir.push_back(Ref{ tag, data + off, (size_t)len });
+    }
+    return true;
+}
+
+// index typu v souboru -> index v načtených unit_types (UINT16_MAX = neznámý)
+using TypeRemap = std::vector<uint16_t>;
+static uint16_t type_of(const TypeRemap& remap, uint16_t t){ return t < remap.size() ? remap[t] : (uint16_t)UINT16_MAX; }
+
+static Building get_building(In& bi, const TypeRemap& remap){
+    Building b{};
+    b.id = bi.u32(); const uint8_t kind = bi.u8(); b.state = (BuildState)bi.u8();
+    if(kind >= kBuildingKinds) bi.ok = false; // get_btype() indexuje tabulkou bez kontroly
+    b.kind = (BuildingKind)kind;
+    b.tile.x = bi.i32(); b.tile.y = bi.i32(); b.w = bi.i32(); b.h = bi.i32();
+    b.build_progress_ms = bi.i32(); b.build_total_ms = bi.i32();
+    b.cost_gold = bi.i32(); b.cost_wood = bi.i32(); b.rally.x = bi.i32(); b.rally.y = bi.i32();
+    for(uint32_t k=0, qn=bi.count(6); k<qn; ++k){
+        uint16_t t = type_of(remap, bi.u16()); int rem = bi.i32();
+        if(t!=UINT16_MAX) b.queue.push_back(TrainItem{ t, rem });
+    }
+    return b;
+}
+static void get_building_timers(In& bt, Building& b, uint32_t tick){
+    b.build_progress_ms = bt.i32(); b.build_since_tick = bt.u32(); b.build_workers = bt.i32(); b.train_due_tick = bt.u32();
+    if(b.build_workers<0 || b.build_since_tick > tick) bt.ok = false;
+}
+// type_index = UINT16_MAX: typ z novější units.csv, jednotka se vynechá
+static Unit get_unit(In& ui, const TypeRemap& remap){
+    Unit u{};
+    u.id = ui.u32(); u.type_index = type_of(remap, ui.u16());
+    u.tile.x = ui.i32(); u.tile.y = ui.i32(); u.goal.x = ui.i32(); u.goal.y = ui.i32();
+    u.hp = ui.i32(); u.job = (UnitJob)ui.u8(); u.carried = ui.i32(); u.carried_kind = ui.u8();
+    u.building_target = ui.u32(); u.owner = ui.u8();
+    if(u.owner >= kMaxPlayers) ui.ok = false;
+    return u;
+}
+static void get_unit_combat(In& ci, Unit& u){ u.cooldown = ci.u16(); u.target = ci.u32(); }
+
+// Bez BLDG/UNIT (delta) zůstanou budovy a jednotky prázdné – doplní apply_entity_delta().
+static bool decode_state(Sim& ns, const std::vector<Ref>& dir, int& w, int& h, TypeRemap& remap){
+    const Ref *meta = find(dir, kMeta), *drops = find(dir, kDrops), *types = find(dir, kTypes),
+              *blds = find(dir, kBuildings), *units = find(dir, kUnits), *players = find(dir, kPlayers),
+              *ucombat = find(dir, kUnitCombat), *btimers = find(dir, kBuildTimers);
+    const bool delta = find(dir, kUnitDelta) && find(dir, kBuildingDelta);
+    if(!meta || !drops || !types || (!delta && (!blds || !units))) return false;
+
+    In mi(meta->p, meta->n);
+    ns.players.assign(1, Player{});
+    Player& p0 = ns.players[0];
+    ns.tick = mi.u32(); p0.gold = mi.i32(); p0.wood = mi.i32(); p0.food_used = mi.i32(); p0.food_cap = mi.i32();
+    ns.next_unit_id = mi.u32(); ns.next_building_id = mi.u32();
+    w = mi.i32(); h = mi.i32();
+    if(!mi.ok || w<0 || h<0) return false;
+
+    In di(drops->p, drops->n);
+    for(uint32_t i=0, n=di.count(8); i<n; ++i){ Vec2i d; d.x=di.i32(); d.y=di.i32(); p0.dropoffs.push_back(d); }
+    if(!di.ok) return false;
+
+    remap.clear();
+    In ti(types->p, types->n);
+    for(uint32_t i=0, n=ti.count(2); i<n && ti.ok; ++i){
+        std::string id = ti.str();
+        remap.push_back(unit_type_id(ns, id));
+    }
+    if(!ti.ok) return false;
+
+    ns.buildings.clear(); ns.units.clear();
+    if(blds && units){
+        In bi(blds->p, blds->n);
+        for(uint32_t i=0, n=bi.count(50); i<n && bi.ok; ++i) ns.buildings.push_back(get_building(bi, remap));
+        if(!bi.ok) return false;
+        if(btimers){
+            In bt(btimers->p, btimers->n);
+            if(bt.count(16) != ns.buildings.size()) return false;
+            for(auto& b: ns.buildings) get_building_timers(bt, b, ns.tick);
+            if(!bt.ok) return false;
+        }else for(auto& b: ns.buildings) b.build_since_tick = ns.tick; // bez stavitelů, viz rebuild_timers()
+
+        In ui(units->p, units->n);
+        const uint32_t nu = ui.count(37);
+        In ci(ucombat ? ucombat->p : nullptr, ucombat ? ucombat->n : 0);
+        if(ucombat && ci.count(6) != nu) return false;
+        for(uint32_t i=0; i<nu && ui.ok; ++i){
+            Unit u = get_unit(ui, remap);
+            if(ucombat) get_unit_combat(ci, u);
+            if(u.type_index!=UINT16_MAX) ns.units.push_back(u);
+        }
+        if(!ui.ok || !ci.ok) return false;
+    }
+    if(!players) return true; // bez PLYR: vše patří hráči 0
+
+    In pi(players->p, players->n);
+    const uint32_t np = pi.u32();
+    if(np<1 || np>(uint32_t)kMaxPlayers) return false;
+    ns.players.resize(np);
+    for(uint32_t p=1; p<np && pi.ok; ++p){
+        Player& pl = ns.players[p];
+        pl.gold = pi.i32(); pl.wood = pi.i32(); pl.food_used = pi.i32(); pl.food_cap = pi.i32();
+        for(uint32_t i=0, n=pi.count(8); i<n; ++i){ Vec2i d; d.x=pi.i32(); d.y=pi.i32(); pl.dropoffs.push_back(d); }
+    }
+    if(pi.count(1) != ns.buildings.size()) return false;
+    for(auto& b: ns.buildings) if((b.owner = pi.u8()) >= np) return false;
+    return pi.ok;
+}
+
+static bool decode_layers(Map& m, const std::vector<Ref>& dir, int w, int h){
+    const Ref *tiles = find(dir, kTiles), *blocked = find(dir, kBlocked), *rkind = find(dir, kResKind),
+              *ramt = find(dir, kResAmount), *rmax = find(dir, kResMax);
+    if(!tiles || !blocked || !rkind || !ramt || !rmax) return false;
+    const size_t cells = (size_t)w * (size_t)h;
+    if(tiles->n!=cells || blocked->n!=cells || rkind->n!=cells || ramt->n!=cells*4 || rmax->n!=cells*4) return false;
+    m.width = w; m.height = h;
+    m.tiles.assign(tiles->p, tiles->p + cells);
+    m.blocked.assign(blocked->p, blocked->p + cells);
+    m.res_kind.assign(rkind->p, rkind->p + cells);
+    m.res_amount.resize(cells); In(ramt->p, ramt->n).ints(m.res_amount.data(), cells);
+    m.res_max.resize(cells);    In(rmax->p, rmax->n).ints(m.res_max.data(), cells);
+    return true;
+}
+
+static bool apply_patch(Map& m, const Ref& r){
+    In in(r.p, r.n);
+    if(in.u32() != (uint32_t)kMapChunk) return false;
+    const uint32_t chunks = (uint32_t)(((m.width + kMapChunk - 1) / kMapChunk) * ((m.height + kMapChunk - 1) / kMapChunk));
+    for(uint32_t i=0, n=in.count(4); i<n && in.ok; ++i){
+        uint32_t c = in.u32();
+        if(c >= chunks) return false;
+        int x0, y0, w, h; chunk_rect(m, (int)c, x0, y0, w, h);
+        if(!in.need((size_t)w*h*11)) return false;
+        for(int y=y0;y<y0+h;++y){ std::memcpy(&m.tiles[(size_t)y*m.width + x0], in.p+in.at, w); in.at += w; }
+        for(int y=y0;y<y0+h;++y){ std::memcpy(&m.blocked[(size_t)y*m.width + x0], in.p+in.at, w); in.at += w; }
+        for(int y=y0;y<y0+h;++y){ std::memcpy(&m.res_kind[(size_t)y*m.width + x0], in.p+in.at, w); in.at += w; }
+        for(int y=y0;y<y0+h;++y) in.ints(&m.res_amount[(size_t)y*m.width + x0], w);
+        for(int y=y0;y<y0+h;++y) in.ints(&m.res_max[(size_t)y*m.width + x0], w);
+    }
+    return in.ok;
+}
+
+// Budovy a jednotky delty v jejím pořadí: nezměněné přesunem z keyframe ('kb', 'ku').
+static bool apply_entity_delta(Sim& ns, const std::vector<Ref>& dir, const TypeRemap& remap,
+                               std::vector<Building>& kb, std::vector<Unit>& ku){
+    const Ref *bd = find(dir, kBuildingDelta), *ud = find(dir, kUnitDelta);
+    std::unordered_map<uint32_t, size_t> at;
+    In bi(bd->p, bd->n);
+    for(size_t i=0;i<kb.size();++i) at[kb[i].id] = i;
+    for(uint32_t i=0, n=bi.count(5); i<n && bi.ok; ++i){
+        if(bi.u8()==0){
+            auto it = at.find(bi.u32());
+            if(it==at.end()){ bi.ok = false; break; } // keyframe ji nemá (nebo už použita)
+            ns.buildings.push_back(std::move(kb[it->second])); at.erase(it);
+            continue;
+        }
+        Building b = get_building(bi, remap);
+        get_building_timers(bi, b, ns.tick);
+        if((b.owner = bi.u8()) >= ns.players.size()) bi.ok = false;
+        ns.buildings.push_back(std::move(b));
+    }
+    if(!bi.ok) return false;
+
+    In ui(ud->p, ud->n);
+    at.clear();
+    for(size_t i=0;i<ku.size();++i) at[ku[i].id] = i;
+    for(uint32_t i=0, n=ui.count(5); i<n && ui.ok; ++i){
+        if(ui.u8()==0){
+            auto it = at.find(ui.u32());
+            if(it==at.end()) continue; // i keyframe ji vynechal (neznámý typ)
+            ns.units.push_back(std::move(ku[it->second])); at.erase(it);
+            continue;
+        }
+        Unit u = get_unit(ui, remap);
+        get_unit_combat(ui, u);
+        if(u.type_index!=UINT16_MAX) ns.units.push_back(u);
+    }
+    return ui.ok;
+}
+
+bool save_is_binary(const uint8_t* data, size_t size){
+    return size >= kHeader && std::memcmp(data, kMagic, 4)==0;
+}
+
+bool save_decode(Sim& ns, const uint8_t* data, size_t size, const std::string& dir_path){
+    std::vector<Ref> dir;
+    if(!parse(data, size, dir)) return false;
+    int w=0, h=0;
+    TypeRemap remap;
+    const Ref* base = find(dir, kBase);
+    if(!base){
+        if(!decode_state(ns, dir, w, h, remap) || find(dir, kUnitDelta)) return false;
+        return decode_layers(ns.map, dir, w, h);
+    }
+
+    // delta: mapa z keyframe + změněné bloky, zbytek stavu z delty
+    In bi(base->p, base->n);
+    uint64_t key_id = bi.u64(); std::string file = bi.str();
+    if(!bi.ok || file.empty() || file.find_first_of("/\\") != std::string::npos) return false;
+    MappedFile kf;
+    if(!mapped_open(kf, dir_path + file)) return false;
+    std::vector<Ref> kdir;
+    if(!parse(kf.data, kf.size, kdir) || find(kdir, kBase)) return false;
+    const Ref* kid = find(kdir, kKeyframe);
+    if(!kid || In(kid->p, kid->n).u64() != key_id) return false; // keyframe mezitím přepsán
+    int kw=0, kh=0;
+    if(!decode_state(ns, kdir, kw, kh, remap) || !decode_layers(ns.map, kdir, kw, kh)) return false;
+    std::vector<Building> kb = std::move(ns.buildings);
+    std::vector<Unit> ku = std::move(ns.units);
+    if(!decode_state(ns, dir, w, h, remap) || w!=kw || h!=kh) return false;
+    // starší delta má entity celé (BLDG/UNIT), novější jen změněné proti keyframe
+    if(find(dir, kUnitDelta) && find(dir, kBuildingDelta) && !apply_entity_delta(ns, dir, remap, kb, ku)) return false;
+    const Ref* patch = find(dir, kPatch);
+    return patch && apply_patch(ns.map, *patch);
+}
+
+// --- řetěz keyframe + delta
+
+static std::string base_name(const std::string& path){
+    size_t k = path.find_last_of("/\\");
+    return k==std::string::npos ? path : path.substr(k+1);
+}
+
+// keyframe, na který ukazuje delta v 'path' ("" = žádná nebo nečitelná)
+static std::string base_on_disk(const std::string& path){
+    MappedFile mf; std::vector<Ref> dir;
+    if(!mapped_open(mf, path) || !parse(mf.data, mf.size, dir)) return {};
+    const Ref* base = find(dir, kBase);
+    if(!base) return {};
+    In bi(base->p, base->n); bi.u64(); std::string file = bi.str();
+    return bi.ok ? file : std::string();
+}
+
+bool save_game_chain(const Sim& s, SaveChain& c, const std::string& path, size_t* chunks_written){
+    const Map& m = s.map;
+    std::vector<uint8_t> buf;
+    if(m.chunk_ver.empty()){ // bez verzí bloků nelze poznat změny
+        save_encode(s, buf);
+        if(chunks_written) *chunks_written = (size_t)-1;
+        return write_file_atomic(path, buf.data(), buf.size());
+    }
+    size_t dirty = 0;
+    for(size_t i=0;i<m.chunk_ver.size();++i) dirty += i>=c.key.chunk_ver.size() || c.key.chunk_ver[i]!=m.chunk_ver[i];
+    const bool key_due = !c.key.id || c.key.w!=m.width || c.key.h!=m.height || c.key.chunk_ver.size()!=m.chunk_ver.size()
+                      || c.deltas >= c.keyframe_every || dirty*2 > m.chunk_ver.size();
+    if(key_due){
+        // střídají se dva sloty: delta na disku ukazuje na starý keyframe, dokud ji nenahradí nová;
+        // první keyframe procesu nesmí přepsat slot delty, kterou zapsal předchozí běh
+        const std::string name = base_name(path), cur = c.key.file.empty() ? base_on_disk(path) : c.key.file;
+        SaveKeyframe k;
+        k.file = name + (cur == name + ".k0" ? ".k1" : ".k0");
+        k.id = hash_mix((uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() ^ ((uint64_t)s.tick << 32) ^ c.key.id);
+        if(!k.id) k.id = 1;
+        k.w = m.width; k.h = m.height; k.chunk_ver = m.chunk_ver;
+        save_keyframe_records(s, k);
+        save_encode(s, buf, k.id);
+        const std::string dir_path = path.substr(0, path.size() - name.size());
+        if(!write_file_atomic(dir_path + k.file, buf.data(), buf.size())) return false;
+        c.key = std::move(k); c.deltas = 0;
+    }
+    size_t n = save_encode_delta(s, c.key, buf);
+    if(chunks_written) *chunks_written = n;
+    if(!write_file_atomic(path, buf.data(), buf.size())) return false;
+    c.deltas++;
+    return true;
+}
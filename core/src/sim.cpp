@@ -2,6 +2,13 @@
 #include "sim.hpp"
 #include "pathfinding.hpp"
 #include "data.hpp"
+#include "combat.hpp"
+#include "state_hash.hpp"
+#include "prof.hpp"
+#include "savegame.hpp"
+#include "mapped_file.hpp"
+#include "fx.hpp"
+#include <cassert>
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
@@ -11,18 +18,24 @@
 
 Sim::Sim(){}
 
-static inline int idx(int w,int x,int y){ return y*w+x; }
 static inline bool in_bounds(const Map& m,int x,int y){ return !(x<0||y<0||x>=m.width||y>=m.height); }
 static inline bool walkable(const Map& m,int x,int y){
     if(!in_bounds(m,x,y)) return false;
-    if(m.blocked[idx(m.width,x,y)]) return false;
-    uint8_t t=m.tiles[idx(m.width,x,y)];
+    if(m.blocked[ridx(m,x,y)]) return false;
+    uint8_t t=m.tiles[ridx(m,x,y)];
     return t!=1; // walls only
 }
 
+static inline int tick_ms(const Sim& s){ return 1000 / s.cfg.tick_rate; }
+
+// stavbu řeší jen budovy, u kterých se změnili stavitelé
+static inline void mark_build_dirty(Sim& s, const Unit& e){
+    if(e.job==UnitJob::Building && e.building_target) s.build_dirty.push_back(e.building_target);
+}
+
 static inline bool is_resource_tile(const Map& m, int x, int y, ResourceKind kind){
     if(x<0||y<0||x>=m.width||y>=m.height) return false;
-    int i = idx(m.width,x,y);
+    int i = ridx(m,x,y);
     return m.res_kind[i] == (uint8_t)kind && m.res_amount[i] > 0;
 }
 
@@ -55,7 +68,7 @@ static bool find_nearest_resource(const Sim& s, Vec2i from, ResourceKind kind, V
     int best = std::numeric_limits<int>::max(); Vec2i bestRes; Vec2i bestStand; bool any=false;
     for(int y=0; y<s.map.height; ++y){
         for(int x=0; x<s.map.width; ++x){
-            int i = idx(s.map.width,x,y);
+            int i = ridx(s.map,x,y);
             if(s.map.res_kind[i] != (uint8_t)kind || s.map.res_amount[i] <= 0) continue;
             // musí existovat aspoň jedno průchozí stání
             Vec2i stand;
@@ -71,28 +84,189 @@ static bool find_nearest_resource(const Sim& s, Vec2i from, ResourceKind kind, V
     return any;
 }
 
-UnitId spawn_unit(Sim& s, const std::string& unit_id, int x, int y){
-    auto it=s.unit_type_index.find(unit_id);
-    if(it==s.unit_type_index.end()) return 0;
-    Unit u{}; u.id=s.next_unit_id++; u.type_index=it->second;
+static void reindex_units(Sim& s){
+    if(s.unit_grid.map_w!=s.map.width || s.unit_grid.map_h!=s.map.height || s.unit_grid.cells.empty())
+        spatial_init(s.unit_grid, s.map.width, s.map.height);
+    else
+        spatial_clear(s.unit_grid);
+    s.unit_occ.assign((size_t)s.map.width*s.map.height, 0);
+    s.unit_slot.assign(s.next_unit_id, UINT32_MAX);
+    for(size_t i=0;i<s.units.size();++i){
+        if(s.units[i].id < s.unit_slot.size()) s.unit_slot[s.units[i].id] = (uint32_t)i;
+        spatial_insert(s.unit_grid, (uint32_t)i, s.units[i].tile);
+        if(in_bounds(s.map, s.units[i].tile.x, s.units[i].tile.y)) s.unit_occ[ridx(s.map,s.units[i].tile.x, s.units[i].tile.y)]++;
+    }
+}
+
+static inline int unit_sight(const Sim& s, const Unit& u){ return s.unit_types[u.type_index].sight_tiles; }
+
+// Player::units / buildings: přidání na konec, odebrání prohozením s posledním (ix = id -> pozice)
+static void owned_add(std::vector<uint32_t>& list, std::vector<uint32_t>& ix, uint32_t id){
+    if(ix.size() <= id) ix.resize((size_t)id+1, UINT32_MAX);
+    ix[id] = (uint32_t)list.size(); list.push_back(id);
+}
+static void owned_remove(std::vector<uint32_t>& list, std::vector<uint32_t>& ix, uint32_t id){
+    if(id >= ix.size() || ix[id]==UINT32_MAX) return;
+    const uint32_t k = ix[id], last = list.back();
+    list[k] = last; ix[last] = k;
+    list.pop_back(); ix[id] = UINT32_MAX;
+}
+
+static bool ensure_player(Sim& s, int owner){
+    if(owner >= kMaxPlayers) return false;
+    if(owner >= (int)s.players.size()) s.players.resize((size_t)owner+1);
+    return true;
+}
+
+static void reindex_owned(Sim& s){
+    for(auto& p: s.players){ p.units.clear(); p.buildings.clear(); }
+    s.unit_owned_ix.assign(s.next_unit_id, UINT32_MAX);
+    s.building_owned_ix.assign(s.next_building_id, UINT32_MAX);
+    for(const auto& u: s.units)     if(ensure_player(s, u.owner)) owned_add(s.players[u.owner].units, s.unit_owned_ix, u.id);
+    for(const auto& b: s.buildings) if(ensure_player(s, b.owner)) owned_add(s.players[b.owner].buildings, s.building_owned_ix, b.id);
+}
+
+bool set_player_count(Sim& s, int n){
+    if(n<1 || n>kMaxPlayers) return false;
+    for(size_t p=n; p<s.players.size(); ++p)
+        if(!s.players[p].units.empty() || !s.players[p].buildings.empty()) return false;
+    s.players.resize((size_t)n);
+    return true;
+}
+
+void rebuild_unit_index(Sim& s){
+    reindex_units(s);
+    reindex_owned(s);
+    // po hromadné změně jsou všichni vzhůru, uspí je až další step()
+    s.awake.clear(); s.awake_sorted = true;
+    for(auto& u: s.units){ u.asleep = false; s.awake.push_back(u.id); }
+    // plná přestavba viditelnosti jen při hromadné změně; explored zůstává
+    if(s.fog.w!=s.map.width || s.fog.h!=s.map.height) fog_init(s.fog, s.map.width, s.map.height);
+    else fog_clear_visible(s.fog);
+    for(const auto& u: s.units) fog_add_unit(s.fog, u.owner, u.tile, unit_sight(s,u));
+}
+
+Unit* find_unit(Sim& s, UnitId id){
+    if(id>=s.unit_slot.size() || s.unit_slot[id]==UINT32_MAX) return nullptr;
+    return &s.units[s.unit_slot[id]];
+}
+const Unit* find_unit(const Sim& s, UnitId id){
+    if(id>=s.unit_slot.size() || s.unit_slot[id]==UINT32_MAX) return nullptr;
+    return &s.units[s.unit_slot[id]];
+}
+
+// Bez přestavby indexů přes celou mapu: mrtví opustí unit_occ, přeživším za
+// prvním mrtvým se přečísluje slot v unit_slot a v buňkách mřížky, kde leží.
+void remove_dead_units(Sim& s){
+    const size_t n = s.units.size();
+    s.slot_remap.resize(n); s.remap_cells.clear();
+    size_t w=0;
+    for(size_t i=0;i<n;++i){
+        Unit& u = s.units[i];
+        if(w!=i || u.hp<=0) s.remap_cells.push_back(spatial_cell(s.unit_grid, u.tile));
+        if(u.hp<=0){
+            s.slot_remap[i] = UINT32_MAX;
+            if(in_bounds(s.map, u.tile.x, u.tile.y)) s.unit_occ[ridx(s.map,u.tile.x, u.tile.y)]--;
+            if(u.id < s.unit_slot.size()) s.unit_slot[u.id] = UINT32_MAX;
+            Player& pl = s.players[u.owner];
+            pl.food_used = std::max(0, pl.food_used - s.unit_types[u.type_index].food);
+            owned_remove(pl.units, s.unit_owned_ix, u.id);
+            fog_remove_unit(s.fog, u.owner, u.tile, unit_sight(s,u));
+            mark_build_dirty(s,u);
+            s.hash_acc ^= hash_unit(u);
+            continue;
+        }
+        s.slot_remap[i] = (uint32_t)w;
+        if(w!=i){ s.unit_slot[u.id] = (uint32_t)w; s.units[w] = std::move(u); }
+        ++w;
+    }
+    if(w==n) return;
+    s.units.resize(w);
+    std::sort(s.remap_cells.begin(), s.remap_cells.end());
+    s.remap_cells.erase(std::unique(s.remap_cells.begin(), s.remap_cells.end()), s.remap_cells.end());
+    for(int c: s.remap_cells) spatial_remap_cell(s.unit_grid, c, s.slot_remap);
+}
+
+bool tile_occupied(const Sim& s, int x, int y){
+    if(!in_bounds(s.map,x,y) || s.unit_occ.empty()) return false;
+    return s.unit_occ[ridx(s.map,x,y)] > 0;
+}
+
+// jediné místo, kde se mění Unit::tile za běhu (drží unit_grid, unit_occ a fog v synchronizaci);
+// hash_acc řeší UnitHashScope volajícího (unit_step ve step())
+static void move_unit_tile(Sim& s, Unit& e, Vec2i to){
+    spatial_move(s.unit_grid, (uint32_t)(&e - s.units.data()), e.tile, to);
+    fog_move_unit(s.fog, e.owner, e.tile, to, unit_sight(s,e));
+    if(in_bounds(s.map, e.tile.x, e.tile.y)) s.unit_occ[ridx(s.map,e.tile.x, e.tile.y)]--;
+    if(in_bounds(s.map, to.x, to.y))         s.unit_occ[ridx(s.map,to.x, to.y)]++;
+    e.tile = to;
+    mark_build_dirty(s,e);
+}
+
+// Uhni na volnou sousední dlaždici, ze které je 'next' stále dosažitelné jedním krokem.
+// Preferuje dlaždici nejblíž k dalšímu bodu cesty.
+static bool find_sidestep(const Sim& s, const Unit& e, Vec2i* out){
+    Vec2i next = e.path.front();
+    Vec2i after = e.path.size()>1 ? e.path[1] : next;
+    int bestd = std::numeric_limits<int>::max(); bool found=false;
+    for(int dy=-1; dy<=1; ++dy) for(int dx=-1; dx<=1; ++dx){
+        if(dx==0 && dy==0) continue;
+        Vec2i n{ e.tile.x+dx, e.tile.y+dy };
+        if(n.x==next.x && n.y==next.y) continue;
+        if(std::abs(n.x-next.x)>1 || std::abs(n.y-next.y)>1) continue;
+        if(!walkable(s.map,n.x,n.y) || tile_occupied(s,n.x,n.y)) continue;
+        int d = (n.x-after.x)*(n.x-after.x) + (n.y-after.y)*(n.y-after.y);
+        if(d<bestd){ bestd=d; *out=n; found=true; }
+    }
+    return found;
+}
+
+UnitTypeId unit_type_id(const Sim& s, std::string_view unit_id){
+    UnitTypeId t = s.unit_type_index.find(unit_id);
+    return t < s.unit_types.size() ? t : kNoUnitType;
+}
+
+UnitId spawn_unit(Sim& s, std::string_view unit_id, int x, int y, uint8_t owner){
+    return spawn_unit(s, unit_type_id(s, unit_id), x, y, owner);
+}
+
+UnitId spawn_unit(Sim& s, UnitTypeId type, int x, int y, uint8_t owner){
+    if(type >= s.unit_types.size() || !ensure_player(s, owner)) return 0;
+    Unit u{}; u.id=s.next_unit_id++; u.type_index=type; u.owner=owner;
     u.tile={x,y}; u.goal={x,y}; u.hp=s.unit_types[u.type_index].hp; u.cooldown=0;
-    s.units.push_back(u); return u.id;
+    if(s.unit_grid.map_w!=s.map.width || s.unit_grid.map_h!=s.map.height) rebuild_unit_index(s);
+    s.units.push_back(u);
+    if(s.unit_slot.size() < s.next_unit_id) s.unit_slot.resize(s.next_unit_id, UINT32_MAX);
+    s.unit_slot[u.id] = (uint32_t)(s.units.size()-1);
+    spatial_insert(s.unit_grid, (uint32_t)(s.units.size()-1), u.tile);
+    if(in_bounds(s.map,x,y)) s.unit_occ[ridx(s.map,x,y)]++;
+    fog_add_unit(s.fog, owner, u.tile, unit_sight(s,u));
+    owned_add(s.players[owner].units, s.unit_owned_ix, u.id);
+    s.awake.push_back(u.id); // nejvyšší id, pořadí zůstává
+    s.hash_acc ^= hash_unit(u);
+    return u.id;
 }
 
 void order_move(Sim& s, UnitId u, int gx, int gy){
-    for(auto& e: s.units) if(e.id==u){
-        e.goal={gx,gy}; e.job=UnitJob::Moving; e.path.clear();
+    if(Unit* pe = find_unit(s,u)){ Unit& e = *pe;
+        UnitHashScope hs(s.hash_acc, e);
+        mark_build_dirty(s,e);
+        wake_unit(s,e,WakeReason::Order);
+        e.goal={gx,gy}; e.job=UnitJob::Moving; e.path.clear(); e.target=0;
         astar_find(s.map, e.tile, e.goal, e.path, true);
-        break;
     }
 }
 
 void order_gather(Sim& s, UnitId u, int tx, int ty){
-    for(auto& e: s.units) if(e.id==u){
+    if(Unit* pe = find_unit(s,u)){ Unit& e = *pe;
+        UnitHashScope hs(s.hash_acc, e);
+        mark_build_dirty(s,e);
+        wake_unit(s,e,WakeReason::Order);
+        e.target=0;
         // Urči typ suroviny primárně z res_* polí
         ResourceKind kind = ResourceKind::None;
         if(tx>=0 && ty>=0 && tx<s.map.width && ty<s.map.height){
-            int i = idx(s.map.width,tx,ty);
+            int i = ridx(s.map,tx,ty);
             if(s.map.res_kind[i] == (uint8_t)ResourceKind::Gold) kind = ResourceKind::Gold;
             else if(s.map.res_kind[i] == (uint8_t)ResourceKind::Wood) kind = ResourceKind::Wood;
             else {
@@ -126,47 +300,98 @@ void order_gather(Sim& s, UnitId u, int tx, int ty){
     }
 }
 
+void order_build(Sim& s, UnitId u, BuildingId bid){
+    Unit* e = find_unit(s,u);
+    const Building* b = find_building(s,bid);
+    if(!e || !b || e->owner!=b->owner) return;
+    UnitHashScope hs(s.hash_acc, *e);
+    mark_build_dirty(s,*e);
+    wake_unit(s,*e,WakeReason::Order);
+    e->job = UnitJob::Building; e->building_target = bid; e->target = 0;
+    mark_build_dirty(s,*e);
+
+    // najdi okrajové políčko kolem footprintu
+    Vec2i best = e->tile; int bestd=1e9; bool found=false;
+    for(int yy=b->tile.y-1; yy<=b->tile.y+b->h; ++yy){
+        for(int xx=b->tile.x-1; xx<=b->tile.x+b->w; ++xx){
+            bool onEdge = !(xx>=b->tile.x && xx<b->tile.x+b->w && yy>=b->tile.y && yy<b->tile.y+b->h);
+            if(onEdge && walkable(s.map,xx,yy)){
+                int d = std::abs(xx-e->tile.x)+std::abs(yy-e->tile.y);
+                if(d<bestd){ bestd=d; best={xx,yy}; found=true; }
+            }
+        }
+    }
+    if(found){
+        e->goal=best; e->path.clear();
+        astar_find(s.map, e->tile, e->goal, e->path, true);
+    }
+}
 
-Vec2i nearest_dropoff(const Sim& s, Vec2i from){
+Vec2i nearest_dropoff(const Sim& s, int owner, Vec2i from){
     int best=std::numeric_limits<int>::max(); Vec2i ret = from;
-    for(auto d: s.dropoffs){
+    if(owner >= (int)s.players.size()) return ret;
+    for(auto d: s.players[owner].dropoffs){
         int dist = std::abs(d.x-from.x)+std::abs(d.y-from.y);
         if(dist<best){ best=dist; ret=d; }
     }
     return ret;
 }
 
-BuildingType get_btype(BuildingKind k){
-    if(k==BuildingKind::Farm) return BuildingType{BuildingKind::Farm,"farm",1,1, 60, 40, 1200, 4};
-    if(k==BuildingKind::Barracks) return BuildingType{BuildingKind::Barracks,"barracks",2,2, 150, 80, 5000, 0};
-    return BuildingType{BuildingKind::Dropoff,"dropoff",1,1, 120, 0, 1500, 0};
+void map_apply(Sim& s, int i, const MapEdit& e){
+    Map& m = s.map;
+    s.hash_acc ^= hash_tile(m, i);
+    if(e.layers & kLayerTiles)     m.tiles[i] = e.tile;
+    if(e.layers & kLayerBlocked)   m.blocked[i] = e.blocked;
+    if(e.layers & kLayerResKind)   m.res_kind[i] = e.res_kind;
+    if(e.layers & kLayerResAmount) m.res_amount[i] = e.res_amount;
+    if(e.layers & kLayerResMax)    m.res_max[i] = e.res_max;
+    s.hash_acc ^= hash_tile(m, i);
+    map_touch(m, i, e.layers);
 }
 
-static void set_block(Map& m, int x, int y, int w, int h, bool on) {
+int map_subscribe(Sim& s, std::function<void(const Sim&, const std::vector<MapChange>&)> fn){
+    s.map_subs.emplace_back(s.next_map_sub, std::move(fn));
+    return s.next_map_sub++;
+}
+
+void map_unsubscribe(Sim& s, int id){
+    for(size_t k=0;k<s.map_subs.size();++k) if(s.map_subs[k].first==id){ s.map_subs.erase(s.map_subs.begin()+k); return; }
+}
+
+void map_publish(Sim& s){
+    if(s.map.journal.empty()) return;
+    for(auto& sub: s.map_subs) sub.second(s, s.map.journal);
+    s.map.journal.clear();
+}
+
+static void set_block(Sim& s, int x, int y, int w, int h, bool on) {
+    Map& m = s.map;
     for (int j = 0; j < h; ++j)
         for (int i = 0; i < w; ++i) {
             int nx = x + i, ny = y + j;
             if (nx >= 0 && ny >= 0 && nx < m.width && ny < m.height)
-                m.blocked[ny * m.width + nx] = on ? 1 : 0;
+                map_set_blocked(s, ny * m.width + nx, on);
         }
 }
 
-bool can_place_building(const Sim& s, BuildingType bt, int x, int y){
+bool can_place_building(const Sim& s, const BuildingType& bt, int x, int y){
     for(int j=0;j<bt.h;++j) for(int i=0;i<bt.w;++i){
         int nx=x+i, ny=y+j;
         if(!in_bounds(s.map,nx,ny)) return false;
-        if(s.map.blocked[idx(s.map.width,nx,ny)]) return false;
-        uint8_t t = s.map.tiles[idx(s.map.width,nx,ny)];
+        if(s.map.blocked[ridx(s.map,nx,ny)]) return false;
+        uint8_t t = s.map.tiles[ridx(s.map,nx,ny)];
         if(t!=0) return false;
     }
     return true;
 }
 
-BuildingId start_building(Sim& s, BuildingType bt, int x, int y) {
-    if (s.gold < bt.cost_gold || s.wood < bt.cost_wood) return 0;
+BuildingId start_building(Sim& s, const BuildingType& bt, int x, int y, uint8_t owner) {
+    if (!ensure_player(s, owner)) return 0;
+    Player& pl = s.players[owner];
+    if (!can_afford(pl, bt)) return 0;
     if (!can_place_building(s, bt, x, y)) return 0;
 
-    s.gold -= bt.cost_gold; s.wood -= bt.cost_wood;
+    pl.gold -= bt.cost_gold; pl.wood -= bt.cost_wood;
 
     Building b{};
     b.id = s.next_building_id++;
@@ -177,22 +402,40 @@ BuildingId start_building(Sim& s, BuildingType bt, int x, int y) {
     b.build_total_ms = bt.build_ms;
     b.cost_gold = bt.cost_gold;
     b.cost_wood = bt.cost_wood;
+    b.owner = owner;
 
     s.buildings.push_back(b);
-    set_block(s.map, x, y, bt.w, bt.h, /*on=*/true);
+    owned_add(pl.buildings, s.building_owned_ix, b.id);
+    s.hash_acc ^= hash_building(b);
+    set_block(s, x, y, bt.w, bt.h, /*on=*/true);
     return b.id;
 }
 
+// zaparkovaní stavitelé (a při skladu i nosiči) hráče se probudí při dokončení / zboření
+static void wake_builders(Sim& s, const Building& b){
+    for(UnitId id: s.players[b.owner].units){
+        Unit& u = *find_unit(s, id);
+        if(!u.asleep) continue;
+        bool builder = u.job==UnitJob::Building && u.building_target==b.id;
+        bool courier = u.job==UnitJob::Delivering && b.kind==BuildingKind::Dropoff;
+        if(builder || courier) wake_unit(s, u, WakeReason::Building);
+    }
+}
+
 void cancel_building(Sim& s, BuildingId id, bool refund) {
     for (size_t i = 0; i < s.buildings.size(); ++i) {
         if (s.buildings[i].id == id) {
             Building b = s.buildings[i];
-            set_block(s.map, b.tile.x, b.tile.y, b.w, b.h, /*on=*/false);
+            set_block(s, b.tile.x, b.tile.y, b.w, b.h, /*on=*/false);
+            Player& pl = s.players[b.owner];
             if (refund && b.state != BuildState::Complete) {
-                s.gold += b.cost_gold;
-                s.wood += b.cost_wood;
+                pl.gold += b.cost_gold;
+                pl.wood += b.cost_wood;
             }
+            s.hash_acc ^= hash_building(b);
             s.buildings.erase(s.buildings.begin() + i);
+            owned_remove(pl.buildings, s.building_owned_ix, id);
+            wake_builders(s, b);
             return;
         }
     }
@@ -203,28 +446,30 @@ void remove_building(Sim& s, BuildingId id, bool refund){
         if(s.buildings[i].id!=id) continue;
         Building b = s.buildings[i];
 
-        set_block(s.map, b.tile.x, b.tile.y, b.w, b.h, false);
+        set_block(s, b.tile.x, b.tile.y, b.w, b.h, false);
 
+        Player& pl = s.players[b.owner];
         // refund jen pokud nebyla dokončená
         if(refund && b.state != BuildState::Complete){
-            s.gold += b.cost_gold;
-            s.wood += b.cost_wood;
+            pl.gold += b.cost_gold;
+            pl.wood += b.cost_wood;
         }
 
         // pokud to byl hotový Dropoff, smaž i z registru dropoffů
         if(b.state == BuildState::Complete && b.kind == BuildingKind::Dropoff){
-            auto it = std::find_if(s.dropoffs.begin(), s.dropoffs.end(),
+            auto it = std::find_if(pl.dropoffs.begin(), pl.dropoffs.end(),
                 [&](const Vec2i& d){ return d.x==b.tile.x && d.y==b.tile.y; });
-            if(it != s.dropoffs.end()) s.dropoffs.erase(it);
+            if(it != pl.dropoffs.end()) pl.dropoffs.erase(it);
         }
 
+        s.hash_acc ^= hash_building(b);
         s.buildings.erase(s.buildings.begin()+i);
+        owned_remove(pl.buildings, s.building_owned_ix, id);
+        wake_builders(s, b);
         return;
     }
 }
 
-static inline int IDX(int w,int x,int y){ return y*w + x; }
-
 void init_resources_from_tiles(Sim& sim, int wood_amount, int gold_amount){
     auto& m = sim.map;
     m.res_kind.resize(m.width * m.height);
@@ -233,7 +478,7 @@ void init_resources_from_tiles(Sim& sim, int wood_amount, int gold_amount){
 
     for(int y=0;y<m.height;++y){
         for(int x=0;x<m.width;++x){
-            int i = IDX(m.width,x,y);
+            int i = ridx(m,x,y);
             uint8_t t = m.tiles[i];
             if(t == 3){ // forest
                 m.res_kind[i]   = (uint8_t)ResourceKind::Wood;
@@ -250,33 +495,98 @@ void init_resources_from_tiles(Sim& sim, int wood_amount, int gold_amount){
             }
         }
     }
+    map_touch_all(m);
+    rebuild_state_hash(sim);
 }
 
 bool resource_take_at(Sim& sim, int x, int y, int amount, int* actually_taken){
     auto& m = sim.map;
     if(x<0||y<0||x>=m.width||y>=m.height) return false;
-    int i = IDX(m.width,x,y);
+    int i = ridx(m,x,y);
     if(m.res_kind[i] == (uint8_t)ResourceKind::None || m.res_amount[i] <= 0) return false;
 
     int take = std::min(amount, m.res_amount[i]);
-    m.res_amount[i] -= take;
     if(actually_taken) *actually_taken = take;
 
-    if(m.res_amount[i] <= 0){
-        // vyčerpáno → změň na trávu a odblokuj
-        m.tiles[i]    = 0;
-        m.blocked[i]  = 0;
-        m.res_kind[i] = (uint8_t)ResourceKind::None;
-        m.res_amount[i] = 0;
-    }
+    MapEdit e;
+    e.res_amount = m.res_amount[i] - take;
+    if(e.res_amount > 0) e.layers = kLayerResAmount;
+    else e.layers = kLayerTiles | kLayerBlocked | kLayerResKind | kLayerResAmount; // vyčerpáno → tráva, odblokuj
+    map_apply(sim, i, e);
     return true;
 }
 
-static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
+void wake_unit(Sim& s, Unit& u, WakeReason why){
+    if(!u.asleep) return;
+    u.asleep = false; u.wake_gen++; // případný naplánovaný sken se zahodí
+    u.woke_by = why;
+    s.awake.push_back(u.id); s.awake_sorted = false;
+}
+
+static constexpr uint32_t kIdleScanTicks = 2*kAcquireEvery; // jak často se zaparkovaný voják rozhlédne
+
+// Jednotka nemá co dělat a čeká jen na vnější událost (rozkaz, zásah, dokončení budovy).
+static bool can_park(const Sim& s, const Unit& e){
+    if(!e.path.empty() || e.cooldown || e.blocked_ticks) return false;
+    switch(e.job){
+        case UnitJob::Idle: return true;
+        case UnitJob::Building:{ // stojí u stavby (nebo k ní nevede cesta)
+            const Building* b = find_building(s, e.building_target);
+            return b && b->state!=BuildState::Complete;
+        }
+        case UnitJob::Delivering:{ // ke skladu nevede cesta
+            Vec2i d = nearest_dropoff(s, e.owner, e.tile);
+            return e.tile.x!=d.x || e.tile.y!=d.y;
+        }
+        default: return false;
+    }
+}
+
+static void park_unit(Sim& s, Unit& e){
+    e.asleep = true; e.wake_gen++;
+    if(e.job==UnitJob::Idle && s.unit_types[e.type_index].attack.damage>0){
+        // periodický sken nepřátel, zarovnaný na akviziční tick v combat_step
+        uint32_t due = s.tick + 1 + kIdleScanTicks;
+        due += (kAcquireEvery - (due + e.id) % kAcquireEvery) % kAcquireEvery;
+        timer_schedule(s.timers, TimerEvent{ due, TimerKind::UnitWake, e.id, e.wake_gen });
+    }
+}
+
+static void unit_step(Sim& s, Unit& e){
+    if(e.job==UnitJob::Building){
+        const Building* b = find_building(s, e.building_target);
+        if(!b || b->state==BuildState::Complete){ // hotovo / zbořeno
+            e.job = UnitJob::Idle; e.building_target = 0; e.path.clear();
+            return;
+        }
+    }
     if(!e.path.empty()){
         auto next=e.path.front();
         if(!walkable(s.map,next.x,next.y)){ e.path.clear(); return; }
-        e.tile=next; e.path.erase(e.path.begin());
+        // cílovou dlaždici smí sdílet víc jednotek (těžba, doručení), jinde čekej / uhni
+        if(e.path.size()>1 && tile_occupied(s,next.x,next.y)){
+            ++e.blocked_ticks;
+            if(e.blocked_ticks >= s.cfg.repath_after_ticks){
+                e.blocked_ticks = 0;
+                std::vector<Vec2i> detour;
+                if(astar_find(s.map, e.tile, e.goal, detour, true, 8192, &s.unit_occ) && !detour.empty()){
+                    e.path.swap(detour);
+                }else{
+                    // objížďka neexistuje (úzká chodba) – projdi, obsazenost je jen měkká
+                    move_unit_tile(s,e,next); e.path.erase(e.path.begin());
+                }
+                return;
+            }
+            Vec2i side;
+            if(e.blocked_ticks >= 2 && find_sidestep(s, e, &side)){
+                move_unit_tile(s,e,side);
+                Vec2i after = e.path[1];
+                if(std::abs(side.x-after.x)<=1 && std::abs(side.y-after.y)<=1) e.path.erase(e.path.begin());
+            }
+            return;
+        }
+        e.blocked_ticks = 0;
+        move_unit_tile(s,e,next); e.path.erase(e.path.begin());
         return;
     }
     if(e.job==UnitJob::Moving){ e.job=UnitJob::Idle; return; }
@@ -302,7 +612,7 @@ static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
         e.carried += taken;
 
         // Pokud se res vyčerpal, hned si najdi další
-        int i = idx(s.map.width,res.x,res.y);
+        int i = ridx(s.map,res.x,res.y);
         if(s.map.res_amount[i] <= 0){
             Vec2i nextRes, stand;
             if(find_nearest_resource(s, e.tile, kind, &nextRes, &stand)){
@@ -311,7 +621,7 @@ static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
             }else{
                 // nic nezbylo – když něco nese, ať to alespoň doručí
                 if(e.carried>0){
-                    Vec2i d = nearest_dropoff(s, e.tile);
+                    Vec2i d = nearest_dropoff(s, e.owner, e.tile);
                     e.goal=d; e.path.clear();
                     astar_find(s.map, e.tile, e.goal, e.path, true);
                     e.job=UnitJob::Delivering;
@@ -324,7 +634,7 @@ static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
 
         // kapacita -> doručit
         if(e.carried >= 20){
-            Vec2i d = nearest_dropoff(s, e.tile);
+            Vec2i d = nearest_dropoff(s, e.owner, e.tile);
             e.goal = d; e.path.clear();
             astar_find(s.map, e.tile, e.goal, e.path, true);
             e.job = UnitJob::Delivering;
@@ -335,10 +645,10 @@ static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
     if(e.job==UnitJob::GatheringWood){ mine_logic(ResourceKind::Wood); return; }
 
     if(e.job==UnitJob::Delivering){
-        Vec2i d = nearest_dropoff(s, e.tile);
+        Vec2i d = nearest_dropoff(s, e.owner, e.tile);
         if(e.tile.x==d.x && e.tile.y==d.y){
-            if(e.carried_kind==1) s.gold += e.carried;
-            else if(e.carried_kind==2) s.wood += e.carried;
+            if(e.carried_kind==1) s.players[e.owner].gold += e.carried;
+            else if(e.carried_kind==2) s.players[e.owner].wood += e.carried;
             e.carried = 0;
             // po doručení se automaticky vrať k nejbližšímu zdroji stejného typu
             if(e.carried_kind==1 || e.carried_kind==2){
@@ -354,23 +664,54 @@ static void unit_step(Sim& s, Unit& e, uint32_t dt_ms){
             // nic nenašel -> idle
             e.carried_kind=0;
             e.job = UnitJob::Idle;
+        }else{
+            // cesta ke skladu chyběla (probuzení po dostavbě skladu) – zkus znovu
+            e.goal = d; e.path.clear();
+            astar_find(s.map, e.tile, e.goal, e.path, true);
         }
         return;
     }
 }
 
 
-bool queue_train(Sim& s, Building& b, const std::string& unit_id, int count){
-    if(b.kind!=BuildingKind::Barracks) return false;
-    auto it = s.unit_type_index.find(unit_id);
-    if(it==s.unit_type_index.end()) return false;
-    const UnitType& ut = s.unit_types[it->second];
-    for(int i=0;i<count;i++){
-        if(s.gold < ut.cost_gold || s.wood < ut.cost_wood || (s.food_used+ut.food) > s.food_cap) return (i>0);
-        s.gold -= ut.cost_gold; s.wood -= ut.cost_wood; s.food_used += ut.food;
-        b.queue.push_back(TrainItem{ it->second, ut.build_time_ms });
+static inline bool training_runs(const Building& b){
+    return b.kind==BuildingKind::Barracks && b.state==BuildState::Complete && !b.queue.empty();
+}
+
+// naplánuj dokončení přední položky fronty (pokud fronta běží)
+static void start_training(Sim& s, Building& b){
+    b.train_gen++;
+    if(!training_runs(b)) return;
+    int ms = b.queue.front().remaining_ms;
+    uint32_t n = ms<=0 ? 1 : (uint32_t)((ms + tick_ms(s) - 1) / tick_ms(s));
+    b.train_due_tick = s.tick + n;
+    timer_schedule(s.timers, TimerEvent{ b.train_due_tick, TimerKind::TrainDone, b.id, b.train_gen });
+}
+
+int train_remaining_ms(const Sim& s, const Building& b){
+    if(b.queue.empty()) return 0;
+    if(!training_runs(b)) return b.queue.front().remaining_ms;
+    return (int)(b.train_due_tick - s.tick) * tick_ms(s);
+}
+
+bool queue_train(Sim& s, Building& b, std::string_view unit_id, int count){
+    return queue_train(s, b, unit_type_id(s, unit_id), count);
+}
+
+bool queue_train(Sim& s, Building& b, UnitTypeId type, int count){
+    if(b.kind!=BuildingKind::Barracks || type >= s.unit_types.size()) return false;
+    const UnitType& ut = s.unit_types[type];
+    Player& pl = s.players[b.owner];
+    int queued = 0;
+    s.hash_acc ^= hash_building(b);
+    for(; queued<count; queued++){
+        if(pl.gold < ut.cost_gold || pl.wood < ut.cost_wood || (pl.food_used+ut.food) > pl.food_cap) break;
+        pl.gold -= ut.cost_gold; pl.wood -= ut.cost_wood; pl.food_used += ut.food;
+        b.queue.push_back(TrainItem{ type, ut.build_time_ms });
+        if(b.queue.size()==1) start_training(s,b);
     }
-    return true;
+    s.hash_acc ^= hash_building(b);
+    return queued==count || queued>0;
 }
 
 bool cancel_last_train(Sim& s, Building& b){
@@ -378,8 +719,12 @@ bool cancel_last_train(Sim& s, Building& b){
     TrainItem it = b.queue.back();
     const UnitType& ut = s.unit_types[it.unit_type];
     // refund costs and food
-    s.gold += ut.cost_gold; s.wood += ut.cost_wood; s.food_used -= ut.food;
+    Player& pl = s.players[b.owner];
+    pl.gold += ut.cost_gold; pl.wood += ut.cost_wood; pl.food_used -= ut.food;
+    s.hash_acc ^= hash_building(b);
     b.queue.pop_back();
+    if(b.queue.empty()) b.train_gen++; // zahoď naplánované dokončení
+    s.hash_acc ^= hash_building(b);
     return true;
 }
 
@@ -387,76 +732,194 @@ bool cancel_train_at(Sim& s, Building& b, size_t idx){
     if(b.kind!=BuildingKind::Barracks || b.queue.empty()) return false;
     if(idx >= b.queue.size()) return false;
     const UnitType& ut = s.unit_types[b.queue[idx].unit_type];
-    s.gold += ut.cost_gold; s.wood += ut.cost_wood; s.food_used -= ut.food;
+    Player& pl = s.players[b.owner];
+    pl.gold += ut.cost_gold; pl.wood += ut.cost_wood; pl.food_used -= ut.food;
+    s.hash_acc ^= hash_building(b);
     b.queue.erase(b.queue.begin()+idx);
+    if(idx==0) start_training(s,b); // další položka začíná od začátku
+    s.hash_acc ^= hash_building(b);
     return true;
 }
 
-void step(Sim& s, uint32_t dt_ms){
-    for(auto& e: s.units) unit_step(s,e,dt_ms);
+// Stavba: přírůstek za tick při 'workers' stavitelích (rychlost 1 + 3/4 za každého dalšího, fx – bez floatu)
+static inline int build_step_ms(const Sim& s, int workers){
+    const fx speed = fx_add_sat(fx_from_int(1), fx_mul_sat(fx_ratio(3,4), fx_from_int(workers-1)));
+    return fx_mul_int_floor(speed, tick_ms(s));
+}
 
-    // Buildings: construction and queues
-    for(auto& b: s.buildings){
-        // construction
-        int adj_workers = 0;
-        for(auto& u: s.units){
-            if(u.type_index!=0) continue; // worker
-            // worker assigned if targeting this building
-            bool assigned = (u.job==UnitJob::Building && u.building_target==b.id);
-            if(!assigned) continue;
-            // adjacent?
-            int dx = std::max(std::max(b.tile.x - u.tile.x, 0), u.tile.x - (b.tile.x + b.w - 1));
-            int dy = std::max(std::max(b.tile.y - u.tile.y, 0), u.tile.y - (b.tile.y + b.h - 1));
-            if (std::max(dx, dy) == 1) adj_workers++;
-        }
-        if(b.state!=BuildState::Complete && adj_workers>0){
-            b.state = BuildState::Constructing;
-            float speed = 1.0f + 0.75f*(adj_workers-1);
-            b.build_progress_ms += (int)(dt_ms * speed);
-            if (b.build_progress_ms >= b.build_total_ms){
-                b.state = BuildState::Complete;
-                if(b.kind==BuildingKind::Dropoff){
-                    s.dropoffs.push_back({b.tile.x,b.tile.y});
-                    s.map.tiles[idx(s.map.width,b.tile.x,b.tile.y)] = 4;
-                    // >>> umožni stát na dropoffu (aby šlo doručovat)
-                    // dropoff je 1x1, proto odblokuj tuhle jednu tile
-                    for (int j=0;j<b.h;++j) for (int i=0;i<b.w;++i)
-                        s.map.blocked[idx(s.map.width, b.tile.x+i, b.tile.y+j)] = 0;
-                }else if(b.kind==BuildingKind::Farm){
-                    s.food_cap += 4;
-                }
+int building_progress_ms(const Sim& s, const Building& b){
+    if(b.state==BuildState::Complete || b.build_workers<=0) return b.build_progress_ms;
+    return std::min(b.build_total_ms, b.build_progress_ms + (int)(s.tick - b.build_since_tick) * build_step_ms(s, b.build_workers));
+}
+
+static int count_adjacent_builders(const Sim& s, const Building& b, std::vector<uint32_t>& ring){
+    // only units in the 1-tile ring around the footprint can count
+    int adj_workers = 0;
+    ring.clear();
+    spatial_query_rect(s.unit_grid, s.units, b.tile.x-1, b.tile.y-1, b.tile.x+b.w, b.tile.y+b.h, ring);
+    for(uint32_t slot: ring){
+        const Unit& u = s.units[slot];
+        if(u.type_index!=0) continue; // worker
+        // worker assigned if targeting this building
+        bool assigned = (u.job==UnitJob::Building && u.building_target==b.id);
+        if(!assigned) continue;
+        // adjacent?
+        int dx = std::max(std::max(b.tile.x - u.tile.x, 0), u.tile.x - (b.tile.x + b.w - 1));
+        int dy = std::max(std::max(b.tile.y - u.tile.y, 0), u.tile.y - (b.tile.y + b.h - 1));
+        if (std::max(dx, dy) == 1) adj_workers++;
+    }
+    return adj_workers;
+}
+
+// dokončení stavby běžící od build_since_tick rychlostí build_workers (> 0)
+static void schedule_build_done(Sim& s, const Building& b){
+    int step_ms = build_step_ms(s,b.build_workers);
+    int left = b.build_total_ms - b.build_progress_ms;
+    uint32_t n = left<=0 ? 1 : (uint32_t)((left + step_ms - 1) / step_ms);
+    timer_schedule(s.timers, TimerEvent{ b.build_since_tick + n, TimerKind::BuildDone, b.id, b.build_gen });
+}
+
+// Změna počtu stavitelů: zafixuj dosavadní progress a přeplánuj dokončení.
+static void set_build_rate(Sim& s, Building& b, int workers){
+    if(b.state==BuildState::Complete || workers==b.build_workers) return;
+    s.hash_acc ^= hash_building(b);
+    b.build_progress_ms = building_progress_ms(s,b);
+    b.build_since_tick = s.tick;
+    b.build_workers = workers;
+    b.build_gen++;
+    if(workers>0){
+        b.state = BuildState::Constructing;
+        schedule_build_done(s,b);
+    }
+    s.hash_acc ^= hash_building(b);
+}
+
+static void complete_building(Sim& s, Building& b){
+    s.hash_acc ^= hash_building(b);
+    b.build_progress_ms = building_progress_ms(s,b);
+    b.build_workers = 0;
+    b.state = BuildState::Complete;
+    if(b.kind==BuildingKind::Dropoff){
+        s.players[b.owner].dropoffs.push_back({b.tile.x,b.tile.y});
+        map_set_tile(s, ridx(s.map,b.tile.x,b.tile.y), 4);
+        // >>> umožni stát na dropoffu (aby šlo doručovat)
+        // dropoff je 1x1, proto odblokuj tuhle jednu tile
+        set_block(s, b.tile.x, b.tile.y, b.w, b.h, false);
+    }
+    s.players[b.owner].food_cap += get_btype(s, b.kind).food_cap_bonus;
+    start_training(s,b); // fronta naplněná během stavby
+    s.hash_acc ^= hash_building(b);
+    wake_builders(s,b);
+}
+
+static void finish_training(Sim& s, Building& b){
+    // spawn unit near footprint
+    UnitTypeId ut = b.queue.front().unit_type;
+    Vec2i spawn = b.tile; bool found = false;
+    for (int ring = 0; ring < 4 && !found; ++ring) {
+        for (int y = b.tile.y - 1 - ring; y <= b.tile.y + b.h + ring; ++y) {
+            for (int x = b.tile.x - 1 - ring; x <= b.tile.x + b.w + ring; ++x) {
+                if (!in_bounds(s.map, x, y)) continue;
+                if (walkable(s.map, x, y)) { spawn = { x, y }; found = true; break; }
             }
+            if (found) break;
         }
+    }
 
-        // Production
-        if (b.kind == BuildingKind::Barracks && b.state == BuildState::Complete && !b.queue.empty()) {
-            b.queue.front().remaining_ms -= (int)dt_ms;
-            if (b.queue.front().remaining_ms <= 0) {
-                // spawn unit near footprint
-                int ut = b.queue.front().unit_type;
-                Vec2i spawn = b.tile; bool found = false;
-                for (int ring = 0; ring < 4 && !found; ++ring) {
-                    for (int y = b.tile.y - 1 - ring; y <= b.tile.y + b.h + ring; ++y) {
-                        for (int x = b.tile.x - 1 - ring; x <= b.tile.x + b.w + ring; ++x) {
-                            if (!in_bounds(s.map, x, y)) continue;
-                            if (walkable(s.map, x, y)) { spawn = { x, y }; found = true; break; }
-                        }
-                        if (found) break;
-                    }
-                }
+    // VYTVOŘENÍ PROMĚNNÉ uid (tady vznikne!)
+    UnitId uid = spawn_unit(s, ut, spawn.x, spawn.y, b.owner);
+
+    // RALLY POINT: rovnou pošleme jednotku na rally, pokud je nastaven
+    if (b.rally.x >= 0 && b.rally.y >= 0) {
+        order_move(s, uid, b.rally.x, b.rally.y);
+    }
 
-                // VYTVOŘENÍ PROMĚNNÉ uid (tady vznikne!)
-                UnitId uid = spawn_unit(s, s.unit_types[ut].id, spawn.x, spawn.y);
+    s.hash_acc ^= hash_building(b);
+    b.queue.pop_front();
+    start_training(s,b);
+    s.hash_acc ^= hash_building(b);
+}
 
-                // RALLY POINT: rovnou pošleme jednotku na rally, pokud je nastaven
-                if (b.rally.x >= 0 && b.rally.y >= 0) {
-                    order_move(s, uid, b.rally.x, b.rally.y);
-                }
+static void on_timer(Sim& s, const TimerEvent& ev){
+    if(ev.kind==TimerKind::UnitWake){
+        Unit* u = find_unit(s, ev.id);
+        if(u && ev.gen==u->wake_gen) wake_unit(s, *u, WakeReason::Timer);
+        return;
+    }
+    Building* b = find_building(s, ev.id);
+    if(!b) return; // zbořeno
+    if(ev.kind==TimerKind::BuildDone){
+        if(ev.gen==b->build_gen && b->state!=BuildState::Complete) complete_building(s,*b);
+    }else if(ev.kind==TimerKind::TrainDone){
+        if(ev.gen==b->train_gen && training_runs(*b)) finish_training(s,*b);
+    }
+}
 
-                b.queue.pop_front();
-            }
+// Časování budov je buď uložené přesně (binární save se sekcí BTIM), nebo
+// výchozí: bez stavitelů od aktuálního ticku a train_due_tick = 0 (přepočet ze zbytku).
+void rebuild_timers(Sim& s){
+    timer_reset(s.timers, s.tick);
+    s.build_dirty.clear();
+    for(auto& b: s.buildings){
+        if(b.state!=BuildState::Complete){
+            if(b.build_workers>0) schedule_build_done(s,b);
+            s.build_dirty.push_back(b.id); // stavitele přepočítá step(), stejný počet nic nemění
+        }else if(training_runs(b) && b.train_due_tick > s.tick){
+            b.train_gen++;
+            timer_schedule(s.timers, TimerEvent{ b.train_due_tick, TimerKind::TrainDone, b.id, b.train_gen });
+        }else start_training(s,b);
+    }
+}
+
+void step(Sim& s, uint32_t dt_ms){
+    RTS_PROF_SCOPE("step");
+    // vše (pohyb, stavba, výcvik, cooldowny) běží po celých ticích tick_ms(s)
+    assert(dt_ms == (uint32_t)tick_ms(s)); (void)dt_ms;
+    if(!s.awake_sorted){ // probuzení přidávají na konec; drž pořadí podle id jako s.units
+        std::sort(s.awake.begin(), s.awake.end());
+        s.awake_sorted = true;
+    }
+    {
+        RTS_PROF_SCOPE("step.units");
+        for(size_t k=0;k<s.awake.size();++k)
+            if(Unit* e = find_unit(s, s.awake[k])){ UnitHashScope hs(s.hash_acc, *e); unit_step(s,*e); }
+    }
+    {
+        RTS_PROF_SCOPE("step.combat");
+        combat_step(s, (uint32_t)tick_ms(s));
+    }
+
+    // Construction: recount only buildings whose builders changed this tick
+    if(!s.build_dirty.empty()){
+        RTS_PROF_SCOPE("step.buildings");
+        std::vector<BuildingId> dirty; dirty.swap(s.build_dirty);
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        std::vector<uint32_t> ring;
+        for(BuildingId id: dirty){
+            Building* b = find_building(s, id);
+            if(b) set_build_rate(s, *b, count_adjacent_builders(s, *b, ring));
         }
     }
+
+    // Zaparkuj jednotky bez práce (a vyhoď mrtvé)
+    size_t w=0;
+    for(size_t k=0;k<s.awake.size();++k){
+        Unit* e = find_unit(s, s.awake[k]);
+        if(!e) continue;
+        if(can_park(s,*e)){ park_unit(s,*e); continue; }
+        s.awake[w++] = s.awake[k];
+    }
+    s.awake.resize(w);
+
+    s.tick++;
+    // Completions (construction, production) fire exactly at their due tick
+    RTS_PROF_SCOPE("step.timers");
+    s.due_events.clear();
+    timer_advance(s.timers, s.tick, s.due_events);
+    for(size_t i=0;i<s.due_events.size();++i) on_timer(s, s.due_events[i]);
+    map_publish(s);
+    s.tick_hash = state_hash(s);
 }
 
 Building* find_building(Sim& s, BuildingId id){
@@ -470,15 +933,25 @@ const Building* find_building(const Sim& s, BuildingId id){
 
 bool load_data(Sim& s, const std::string& assets_path){
     bool ok1 = load_units_csv(assets_path + "/units.csv", s.unit_types, s.unit_type_index);
-    bool ok2 = load_map_txt(assets_path + "/map.txt", s.map);
-    if(!ok1 || !ok2) return false;
-    // initial dropoffs from map
-    for(int y=0;y<s.map.height;++y)for(int x=0;x<s.map.width;++x)
-        if(s.map.tiles[idx(s.map.width,x,y)]==4) s.dropoffs.push_back({x,y});
+    if(!ok1) return false;
+    s.building_types = kDefaultBuildingTypes;
+    (void)load_buildings_csv(assets_path + "/buildings.csv", s.building_types); // volitelný
+    // kompilovaná mapa (rts_mapc) má sklady i suroviny předpočítané, jinak map.txt;
+    // .rtsmap zkompilovaný z jiné verze map.txt (velikost/čas/CRC zdroje v hlavičce) se přeskočí
+    std::vector<Vec2i>& drops = s.players[0].dropoffs; // mapy jsou zatím jednohráčové
+    const std::string txt = assets_path + "/map.txt";
+    if(!load_map_bin(assets_path + "/map.rtsmap", s.map, drops, &txt)){
+        if(!load_map_txt(txt, s.map)) return false;
+        // initial dropoffs from map
+        for(int y=0;y<s.map.height;++y)for(int x=0;x<s.map.width;++x)
+            if(s.map.tiles[ridx(s.map,x,y)]==4) drops.push_back({x,y});
+    }
     // spawn worker and footman near first drop
-    Vec2i d = s.dropoffs.empty()?Vec2i{1,1}:s.dropoffs[0];
+    Vec2i d = drops.empty()?Vec2i{1,1}:drops[0];
     (void)spawn_unit(s, "worker", d.x+1, d.y);
     (void)spawn_unit(s, "footman", d.x+3, d.y);
+    map_touch_all(s.map);
+    rebuild_state_hash(s);
     return true;
 }
 
@@ -488,13 +961,24 @@ bool load_data(Sim& s, const std::string& assets_path){
 static void write_line(std::ofstream& f, const std::string& s){ f << s << "\n"; }
 
 bool save_game(const Sim& s, const std::string& path){
+    RTS_PROF_SCOPE("save_game");
+    std::vector<uint8_t> buf;
+    save_encode(s, buf);
+    return write_file_atomic(path, buf.data(), buf.size());
+}
+
+bool save_game_text(const Sim& s, const std::string& path){
     std::ofstream f(path, std::ios::trunc);
     if(!f) return false;
 
     write_line(f, "VERSION 1");
-    // ekonomika & id
-    write_line(f, "ECO " + std::to_string(s.gold) + " " + std::to_string(s.wood) + " " +
-                    std::to_string(s.food_used) + " " + std::to_string(s.food_cap));
+    // ekonomika (ECO = hráč 0, PLAYER p = ostatní) & id
+    for(size_t p=0;p<s.players.size();++p){
+        const Player& pl = s.players[p];
+        write_line(f, (p ? "PLAYER " + std::to_string(p) + " " : std::string("ECO ")) +
+                        std::to_string(pl.gold) + " " + std::to_string(pl.wood) + " " +
+                        std::to_string(pl.food_used) + " " + std::to_string(pl.food_cap));
+    }
     write_line(f, "IDS " + std::to_string(s.next_unit_id) + " " + std::to_string(s.next_building_id));
 
     // mapa
@@ -506,7 +990,7 @@ bool save_game(const Sim& s, const std::string& path){
         std::ostringstream row;
         for(int x=0;x<s.map.width;++x){
             if(x) row << ' ';
-            row << int(s.map.tiles[idx(s.map.width,x,y)]);
+            row << int(s.map.tiles[ridx(s.map,x,y)]);
         }
         write_line(f, row.str());
     }
@@ -516,7 +1000,7 @@ bool save_game(const Sim& s, const std::string& path){
         std::ostringstream row;
         for(int x=0;x<s.map.width;++x){
             if(x) row << ' ';
-            row << int(s.map.blocked[idx(s.map.width,x,y)]);
+            row << int(s.map.blocked[ridx(s.map,x,y)]);
         }
         write_line(f, row.str());
     }
@@ -526,7 +1010,7 @@ bool save_game(const Sim& s, const std::string& path){
         std::ostringstream row;
         for(int x=0;x<s.map.width;++x){
             if(x) row << ' ';
-            row << int(s.map.res_kind[idx(s.map.width,x,y)]);
+            row << int(s.map.res_kind[ridx(s.map,x,y)]);
         }
         write_line(f, row.str());
     }
@@ -536,7 +1020,7 @@ bool save_game(const Sim& s, const std::string& path){
         std::ostringstream row;
         for(int x=0;x<s.map.width;++x){
             if(x) row << ' ';
-            row << s.map.res_amount[idx(s.map.width,x,y)];
+            row << s.map.res_amount[ridx(s.map,x,y)];
         }
         write_line(f, row.str());
     }
@@ -545,14 +1029,16 @@ bool save_game(const Sim& s, const std::string& path){
         std::ostringstream row;
         for(int x=0;x<s.map.width;++x){
             if(x) row << ' ';
-            row << s.map.res_max[idx(s.map.width,x,y)];
+            row << s.map.res_max[ridx(s.map,x,y)];
         }
         write_line(f, row.str());
     }
 
     // dropoffy
-    write_line(f, "DROPOFFS " + std::to_string(s.dropoffs.size()));
-    for(auto d : s.dropoffs) write_line(f, "D " + std::to_string(d.x) + " " + std::to_string(d.y));
+    size_t ndrops = 0; for(const auto& pl : s.players) ndrops += pl.dropoffs.size();
+    write_line(f, "DROPOFFS " + std::to_string(ndrops));
+    for(size_t p=0;p<s.players.size();++p)
+        for(auto d : s.players[p].dropoffs) write_line(f, "D " + std::to_string(d.x) + " " + std::to_string(d.y) + " " + std::to_string(p));
 
     // budovy
     write_line(f, "BUILDINGS " + std::to_string(s.buildings.size()));
@@ -561,13 +1047,15 @@ bool save_game(const Sim& s, const std::string& path){
                        std::to_string(b.tile.x) + " " + std::to_string(b.tile.y) + " " +
                        std::to_string(b.w) + " " + std::to_string(b.h) + " " +
                        std::to_string((int)b.state) + " " +
-                       std::to_string(b.build_progress_ms) + " " + std::to_string(b.build_total_ms) + " " +
+                       std::to_string(building_progress_ms(s,b)) + " " + std::to_string(b.build_total_ms) + " " +
                        std::to_string(b.cost_gold) + " " + std::to_string(b.cost_wood) + " " +
-                       std::to_string(b.rally.x) + " " + std::to_string(b.rally.y));
+                       std::to_string(b.rally.x) + " " + std::to_string(b.rally.y) + " " + std::to_string((int)b.owner));
         write_line(f, "BQ " + std::to_string(b.queue.size()));
-        for(const auto& qi : b.queue){
+        for(size_t k=0; k<b.queue.size(); ++k){
+            const auto& qi = b.queue[k];
             const std::string& uid = s.unit_types[qi.unit_type].id;
-            write_line(f, "QI " + uid + " " + std::to_string(qi.remaining_ms));
+            int rem = (k==0) ? train_remaining_ms(s,b) : qi.remaining_ms;
+            write_line(f, "QI " + uid + " " + std::to_string(rem));
         }
     }
 
@@ -580,19 +1068,17 @@ bool save_game(const Sim& s, const std::string& path){
                        std::to_string(u.goal.x) + " " + std::to_string(u.goal.y) + " " +
                        std::to_string(u.hp) + " " + std::to_string((int)u.job) + " " +
                        std::to_string(u.carried) + " " + std::to_string((int)u.carried_kind) + " " +
-                       std::to_string((int)u.building_target));
+                       std::to_string((int)u.building_target) + " " + std::to_string((int)u.owner) + " " +
+                       std::to_string((int)u.cooldown) + " " + std::to_string(u.target));
     }
     return true;
 }
 
-bool load_game(Sim& s, const std::string& path){
+// VERSION 1 (text): starší savy
+static bool load_game_text(Sim& ns, const std::string& path){
     std::ifstream f(path);
     if(!f) return false;
 
-    Sim ns; // dočasný nový stav (pro bezpečné načtení)
-    ns.unit_types = s.unit_types;
-    ns.unit_type_index = s.unit_type_index;
-
     std::string line, tag;
     int width=0, height=0;
 
@@ -602,8 +1088,12 @@ bool load_game(Sim& s, const std::string& path){
     while(std::getline(f,line)){
         if(line.empty()) continue;
         std::istringstream iss(line); iss >> tag;
-        if(tag=="ECO"){
-            iss >> ns.gold >> ns.wood >> ns.food_used >> ns.food_cap;
+        if(tag=="ECO" || tag=="PLAYER"){
+            int p=0;
+            if(tag=="PLAYER" && (!(iss>>p) || p<1 || p>=kMaxPlayers)) return false;
+            if(p >= (int)ns.players.size()) ns.players.resize((size_t)p+1);
+            Player& pl = ns.players[p];
+            iss >> pl.gold >> pl.wood >> pl.food_used >> pl.food_cap;
         }else if(tag=="IDS"){
             iss >> ns.next_unit_id >> ns.next_building_id;
         }else if(tag=="MAP"){
@@ -613,36 +1103,41 @@ bool load_game(Sim& s, const std::string& path){
             ns.map.blocked.assign(width*height,0);
             ns.map.res_kind.assign(width*height,0);
             ns.map.res_amount.assign(width*height,0);
+            ns.map.res_max.assign(width*height,0);
         }else if(tag=="TILES"){
             for(int y=0;y<height;++y){
                 std::getline(f,line); std::istringstream rs(line);
-                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.tiles[idx(width,x,y)]=(uint8_t)v; }
+                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.tiles[ridx(ns.map,x,y)]=(uint8_t)v; }
             }
         }else if(tag=="BLOCKED"){
             for(int y=0;y<height;++y){
                 std::getline(f,line); std::istringstream rs(line);
-                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.blocked[idx(width,x,y)]=(uint8_t)v; }
+                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.blocked[ridx(ns.map,x,y)]=(uint8_t)v; }
             }
         }else if(tag=="RESKIND"){
             for(int y=0;y<height;++y){
                 std::getline(f,line); std::istringstream rs(line);
-                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_kind[idx(width,x,y)]=(uint8_t)v; }
+                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_kind[ridx(ns.map,x,y)]=(uint8_t)v; }
             }
         }else if(tag=="RESAMNT"){
             for(int y=0;y<height;++y){
                 std::getline(f,line); std::istringstream rs(line);
-                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_amount[idx(width,x,y)]=v; }
+                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_amount[ridx(ns.map,x,y)]=v; }
             }
         }else if(tag=="RESMAX"){
             for(int y=0;y<height;++y){
                 std::getline(f,line); std::istringstream rs(line);
-                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_max[idx(width,x,y)]=v; }
+                for(int x=0;x<width;++x){ int v; rs>>v; ns.map.res_max[ridx(ns.map,x,y)]=v; }
             }
         }else if(tag=="DROPOFFS"){
             int n=0; iss>>n;
             for(int i=0;i<n;++i){
                 std::getline(f,line); std::istringstream ds(line); std::string t; ds>>t; // "D"
-                Vec2i d{}; ds>>d.x>>d.y; ns.dropoffs.push_back(d);
+                Vec2i d{}; int owner=0; ds>>d.x>>d.y;
+                if(!(ds>>owner)) owner=0; // starší savy: vše hráči 0
+                if(owner<0 || owner>=kMaxPlayers) return false;
+                if(owner >= (int)ns.players.size()) ns.players.resize((size_t)owner+1);
+                ns.players[owner].dropoffs.push_back(d);
             }
         }else if(tag=="BUILDINGS"){
             int n=0; iss>>n;
@@ -653,6 +1148,9 @@ bool load_game(Sim& s, const std::string& path){
                 bs >> b.id >> kind >> b.tile.x >> b.tile.y >> b.w >> b.h >> state
                    >> b.build_progress_ms >> b.build_total_ms >> b.cost_gold >> b.cost_wood
                    >> b.rally.x >> b.rally.y;
+                int owner=0; if(!(bs>>owner)) owner=0;
+                if(owner<0 || owner>=kMaxPlayers || kind<0 || kind>=kBuildingKinds) return false;
+                b.owner = (uint8_t)owner;
                 b.kind = (BuildingKind)kind;
                 b.state = (BuildState)state;
                 ns.buildings.push_back(b);
@@ -661,26 +1159,52 @@ bool load_game(Sim& s, const std::string& path){
                 std::getline(f,line); std::istringstream qh(line); std::string tq; int qn=0; qh>>tq>>qn;
                 for(int k=0;k<qn;++k){
                     std::getline(f,line); std::istringstream qi(line); std::string qtag, uid; int rem=0; qi>>qtag>>uid>>rem;
-                    auto it = ns.unit_type_index.find(uid);
-                    if(it!=ns.unit_type_index.end()) ns.buildings.back().queue.push_back(TrainItem{ (uint16_t)it->second, rem });
+                    UnitTypeId t = unit_type_id(ns, uid);
+                    if(t!=kNoUnitType) ns.buildings.back().queue.push_back(TrainItem{ t, rem });
                 }
             }
         }else if(tag=="UNITS"){
             int n=0; iss>>n;
             for(int i=0;i<n;++i){
                 std::getline(f,line); std::istringstream us(line); std::string t, uid;
-                Unit u{}; int job, ck;
+                Unit u{}; int job, ck, owner=0;
                 us>>t>>u.id>>uid>>u.tile.x>>u.tile.y>>u.goal.x>>u.goal.y>>u.hp>>job>>u.carried>>ck>>u.building_target;
-                auto it = ns.unit_type_index.find(uid);
-                if(it==ns.unit_type_index.end()) continue;
-                u.type_index = (uint16_t)it->second;
+                if(!(us>>owner)) owner=0; // starší savy bez vlastníka
+                int cd=0; if(us>>cd>>u.target) u.cooldown=(uint16_t)cd; else u.target=0; // ... a bez cooldownu/cíle
+                if(owner<0 || owner>=kMaxPlayers) return false;
+                u.type_index = unit_type_id(ns, uid);
+                if(u.type_index==kNoUnitType) continue;
                 u.job = (UnitJob)job;
                 u.carried_kind = (uint8_t)ck;
+                u.owner = (uint8_t)owner;
                 ns.units.push_back(u);
             }
         }
     }
+    return true;
+}
+
+bool load_game(Sim& s, const std::string& path){
+    RTS_PROF_SCOPE("load_game");
+    Sim ns; // dočasný nový stav (pro bezpečné načtení)
+    ns.unit_types = s.unit_types;
+    ns.unit_type_index = s.unit_type_index;
+    ns.building_types = s.building_types;
+    {
+        MappedFile mf;
+        if(!mapped_open(mf, path)) return false;
+        const std::string dir = path.substr(0, path.find_last_of("/\\")+1);
+        bool ok = save_is_binary(mf.data, mf.size) ? save_decode(ns, mf.data, mf.size, dir) : load_game_text(ns, path);
+        if(!ok) return false;
+    }
 
+    ns.map_subs = std::move(s.map_subs); ns.next_map_sub = s.next_map_sub;
+    ns.map.walk_ix.layout = s.map.walk_ix.layout;
     s = std::move(ns); // přepiš běžící stav
+    rebuild_unit_index(s);
+    rebuild_timers(s);
+    map_touch_all(s.map);
+    rebuild_state_hash(s);
+    map_publish(s);
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "snapshot.hpp"
+#include "prof.hpp"
+#include <algorithm>
+
+// Vše kromě mapy a statických dat (typy jednotek, konfigurace).
+static void copy_dynamic(Sim& d, const Sim& s){
+    d.units = s.units; d.next_unit_id = s.next_unit_id;
+    d.buildings = s.buildings; d.next_building_id = s.next_building_id;
+    d.players = s.players; d.unit_owned_ix = s.unit_owned_ix; d.building_owned_ix = s.building_owned_ix;
+    d.unit_grid = s.unit_grid; d.unit_occ = s.unit_occ; d.unit_slot = s.unit_slot;
+    d.fog.w = s.fog.w; d.fog.h = s.fog.h; d.fog.players = s.fog.players; // stamps jsou jen cache
+    d.tick = s.tick; d.timers = s.timers;
+    d.build_dirty = s.build_dirty; d.awake = s.awake; d.awake_sorted = s.awake_sorted;
+    d.hash_acc = s.hash_acc; d.tick_hash = s.tick_hash;
+}
+
+// Kopie obdélníku bloku mezi mapou (řádky šířky W) a blokem (řádky šířky cw).
+template<class T>
+static void copy_rect(std::vector<T>& dst, int dw, int dx, int dy,
+                      const std::vector<T>& src, int sw, int sx, int sy, int cw, int ch){
+    if(src.empty()) return;
+    for(int r=0;r<ch;++r)
+        std::copy_n(src.begin() + (size_t)(sy+r)*sw + sx, cw, dst.begin() + (size_t)(dy+r)*dw + dx);
+}
+
+struct ChunkRect{ int x0, y0, w, h; };
+static ChunkRect chunk_rect(const Map& m, int c){
+    int cx = c % m.chunk_cols, cy = c / m.chunk_cols;
+    int x0 = cx*kMapChunk, y0 = cy*kMapChunk;
+    return { x0, y0, std::min(kMapChunk, m.width - x0), std::min(kMapChunk, m.height - y0) };
+}
+
+bool snapshot_take(const Sim& s, SimSnapshot& out){
+    RTS_PROF_SCOPE("snapshot_take");
+    const Map& m = s.map;
+    if(m.chunk_ver.size() != (size_t)m.chunk_cols * m.chunk_rows || m.chunk_cols*kMapChunk < m.width
+       || m.chunk_rows*kMapChunk < m.height) return false; // chybí map_touch_all()
+    copy_dynamic(out.state, s);
+
+    if(out.map_w!=m.width || out.map_h!=m.height){
+        out.map_w = m.width; out.map_h = m.height;
+        out.chunks.assign(m.chunk_ver.size(), nullptr);
+        out.chunk_ver.assign(m.chunk_ver.size(), 0);
+    }
+    const bool has_res = !m.res_kind.empty();
+    for(size_t c=0;c<m.chunk_ver.size();++c){
+        if(out.chunks[c] && out.chunk_ver[c]==m.chunk_ver[c]) continue; // beze změny, sdílej
+        ChunkRect r = chunk_rect(m, (int)c);
+        const size_t n = (size_t)r.w * r.h;
+        std::shared_ptr<MapChunk> ch;
+        // blok, který nikdo jiný nesdílí, se přepíše na místě
+        if(out.chunks[c] && out.chunks[c].use_count()==1) ch = std::const_pointer_cast<MapChunk>(out.chunks[c]);
+        else ch = std::make_shared<MapChunk>();
+        ch->tiles.resize(n); ch->blocked.resize(n);
+        copy_rect(ch->tiles, r.w, 0, 0, m.tiles, m.width, r.x0, r.y0, r.w, r.h);
+        copy_rect(ch->blocked, r.w, 0, 0, m.blocked, m.width, r.x0, r.y0, r.w, r.h);
+        ch->res_kind.resize(has_res ? n : 0); ch->res_amount.resize(has_res ? n : 0); ch->res_max.resize(has_res ? n : 0);
+        copy_rect(ch->res_kind, r.w, 0, 0, m.res_kind, m.width, r.x0, r.y0, r.w, r.h);
+        copy_rect(ch->res_amount, r.w, 0, 0, m.res_amount, m.width, r.x0, r.y0, r.w, r.h);
+        if(m.res_max.size()==m.tiles.size()) copy_rect(ch->res_max, r.w, 0, 0, m.res_max, m.width, r.x0, r.y0, r.w, r.h);
+        out.chunks[c] = std::move(ch);
+        out.chunk_ver[c] = m.chunk_ver[c];
+    }
+    return true;
+}
+
+bool snapshot_restore(Sim& s, const SimSnapshot& snap){
+    RTS_PROF_SCOPE("snapshot_restore");
+    if(snap.chunks.empty() && (snap.map_w || snap.map_h)) return false;
+    copy_dynamic(s, snap.state);
+
+    Map& m = s.map;
+    const size_t n = (size_t)snap.map_w * snap.map_h;
+    bool resized = m.width!=snap.map_w || m.height!=snap.map_h;
+    if(resized){
+        m.width = snap.map_w; m.height = snap.map_h;
+        m.tiles.assign(n, 0); m.blocked.assign(n, 0);
+        m.res_kind.assign(n, 0); m.res_amount.assign(n, 0); m.res_max.assign(n, 0);
+        m.chunk_cols = (m.width + kMapChunk - 1) / kMapChunk;
+        m.chunk_rows = (m.height + kMapChunk - 1) / kMapChunk;
+        m.chunk_ver.assign(snap.chunk_ver.size(), 0);
+        for(auto& lv: m.layer_ver) lv.assign(snap.chunk_ver.size(), 0);
+    }
+    if(m.res_kind.size()!=n){ m.res_kind.resize(n); m.res_amount.resize(n); }
+    if(m.res_max.size()!=n) m.res_max.resize(n);
+    bool restored = false;
+    for(size_t c=0;c<snap.chunks.size();++c){
+        if(!resized && m.chunk_ver[c]==snap.chunk_ver[c]) continue; // blok se nezměnil
+        const MapChunk& ch = *snap.chunks[c];
+        ChunkRect r = chunk_rect(m, (int)c);
+        copy_rect(m.tiles, m.width, r.x0, r.y0, ch.tiles, r.w, 0, 0, r.w, r.h);
+        copy_rect(m.blocked, m.width, r.x0, r.y0, ch.blocked, r.w, 0, 0, r.w, r.h);
+        copy_rect(m.res_kind, m.width, r.x0, r.y0, ch.res_kind, r.w, 0, 0, r.w, r.h);
+        copy_rect(m.res_amount, m.width, r.x0, r.y0, ch.res_amount, r.w, 0, 0, r.w, r.h);
+        copy_rect(m.res_max, m.width, r.x0, r.y0, ch.res_max, r.w, 0, 0, r.w, r.h);
+        // obsah bloku = stav při snapshotu -> všechny vrstvy nesou jeho verzi
+        m.chunk_ver[c] = snap.chunk_ver[c];
+        for(auto& lv: m.layer_ver) lv[c] = snap.chunk_ver[c];
+        map_refresh_walk(m, r.x0, r.y0, r.w, r.h);
+        restored = true;
+    }
+    if(resized) map_set_layout(m, m.walk_ix.layout);
+    if(restored){ m.journal.clear(); m.journal.push_back(MapChange{ -1, kLayerAll }); }
+    return true;
+}
@@ -0,0 +1,118 @@
+#include "spatial.hpp"
+#include "sim.hpp"
+#include <algorithm>
+
+static inline int cell_of(const SpatialHash& h, Vec2i t){
+    int cx = std::clamp(t.x, 0, h.map_w-1) >> h.cell_shift;
+    int cy = std::clamp(t.y, 0, h.map_h-1) >> h.cell_shift;
+    return cy*h.cols + cx;
+}
+
+void spatial_init(SpatialHash& h, int map_w, int map_h, int cell_shift){
+    h.cell_shift = cell_shift;
+    h.map_w = std::max(map_w, 1); h.map_h = std::max(map_h, 1);
+    int cs = 1<<cell_shift;
+    h.cols = (h.map_w + cs - 1) / cs;
+    h.rows = (h.map_h + cs - 1) / cs;
+    h.cells.assign((size_t)h.cols*h.rows, {});
+}
+
+void spatial_clear(SpatialHash& h){
+    for(auto& c: h.cells) c.clear();
+}
+
+void spatial_insert(SpatialHash& h, uint32_t slot, Vec2i t){
+    h.cells[cell_of(h,t)].push_back(slot);
+}
+
+void spatial_remove(SpatialHash& h, uint32_t slot, Vec2i t){
+    auto& c = h.cells[cell_of(h,t)];
+    for(size_t i=0;i<c.size();++i) if(c[i]==slot){ c[i]=c.back(); c.pop_back(); return; }
+}
+
+void spatial_move(SpatialHash& h, uint32_t slot, Vec2i from, Vec2i to){
+    int a = cell_of(h,from), b = cell_of(h,to);
+    if(a==b) return; // většina kroků zůstává ve stejné buňce
+    auto& c = h.cells[a];
+    for(size_t i=0;i<c.size();++i) if(c[i]==slot){ c[i]=c.back(); c.pop_back(); break; }
+    h.cells[b].push_back(slot);
+}
+
+int spatial_cell(const SpatialHash& h, Vec2i t){ return cell_of(h,t); }
+
+void spatial_remap_cell(SpatialHash& h, int cell, const std::vector<uint32_t>& remap){
+    auto& c = h.cells[cell];
+    size_t w=0;
+    for(uint32_t s: c) if(remap[s]!=UINT32_MAX) c[w++] = remap[s];
+    c.resize(w);
+}
+
+void spatial_query_rect(const SpatialHash& h, const std::vector<Unit>& units,
+                        int x0, int y0, int x1, int y1, std::vector<uint32_t>& out){
+    if(h.cells.empty()) return;
+    if(x0>x1) std::swap(x0,x1);
+    if(y0>y1) std::swap(y0,y1);
+    if(x1<0 || y1<0 || x0>=h.map_w || y0>=h.map_h) return;
+    int cx0 = std::max(x0,0)>>h.cell_shift, cx1 = std::min(x1,h.map_w-1)>>h.cell_shift;
+    int cy0 = std::max(y0,0)>>h.cell_shift, cy1 = std::min(y1,h.map_h-1)>>h.cell_shift;
+    for(int cy=cy0; cy<=cy1; ++cy) for(int cx=cx0; cx<=cx1; ++cx){
+        for(uint32_t s: h.cells[cy*h.cols+cx]){
+            const Vec2i& t = units[s].tile;
+            if(t.x>=x0 && t.x<=x1 && t.y>=y0 && t.y<=y1) out.push_back(s);
+        }
+    }
+}
+
+void spatial_query_radius(const SpatialHash& h, const std::vector<Unit>& units,
+                          Vec2i c, int r, std::vector<uint32_t>& out){
+    if(h.cells.empty() || r<0) return;
+    int cx0 = std::max(c.x-r,0)>>h.cell_shift, cx1 = std::min(c.x+r,h.map_w-1)>>h.cell_shift;
+    int cy0 = std::max(c.y-r,0)>>h.cell_shift, cy1 = std::min(c.y+r,h.map_h-1)>>h.cell_shift;
+    if(c.x+r<0 || c.y+r<0 || c.x-r>=h.map_w || c.y-r>=h.map_h) return;
+    const int r2 = r*r;
+    for(int cy=cy0; cy<=cy1; ++cy) for(int cx=cx0; cx<=cx1; ++cx){
+        for(uint32_t s: h.cells[cy*h.cols+cx]){
+            int dx = units[s].tile.x-c.x, dy = units[s].tile.y-c.y;
+            if(dx*dx+dy*dy <= r2) out.push_back(s);
+        }
+    }
+}
+
+void spatial_knearest(const SpatialHash& h, const std::vector<Unit>& units,
+                      Vec2i c, int k, std::vector<uint32_t>& out, int max_r){
+    if(h.cells.empty() || k<=0) return;
+    struct Cand{ int d2; uint32_t slot; };
+    std::vector<Cand> cand;
+    const int cs = 1<<h.cell_shift;
+    const int maxr2 = (max_r<0) ? -1 : max_r*max_r;
+    Vec2i cc{ std::clamp(c.x,0,h.map_w-1)>>h.cell_shift, std::clamp(c.y,0,h.map_h-1)>>h.cell_shift };
+    const int max_ring = std::max(h.cols, h.rows);
+    auto kth = [&](){
+        std::nth_element(cand.begin(), cand.begin()+(k-1), cand.end(),
+            [](const Cand& a, const Cand& b){ return a.d2<b.d2 || (a.d2==b.d2 && a.slot<b.slot); });
+        return cand[k-1].d2;
+    };
+    for(int ring=0; ring<=max_ring; ++ring){
+        // buňky v Chebyshevově vzdálenosti 'ring' od středové buňky
+        for(int cy=cc.y-ring; cy<=cc.y+ring; ++cy){
+            if(cy<0 || cy>=h.rows) continue;
+            bool edge_row = (cy==cc.y-ring || cy==cc.y+ring);
+            for(int cx=cc.x-ring; cx<=cc.x+ring; cx += (edge_row||ring==0) ? 1 : 2*ring){
+                if(cx<0 || cx>=h.cols) continue;
+                for(uint32_t s: h.cells[cy*h.cols+cx]){
+                    int dx = units[s].tile.x-c.x, dy = units[s].tile.y-c.y;
+                    int d2 = dx*dx+dy*dy;
+                    if(maxr2>=0 && d2>maxr2) continue;
+                    cand.push_back({d2,s});
+                }
+            }
+        }
+        // cokoli za tímto prstencem je dál než ring*cs dlaždic
+        int reach = ring*cs;
+        if(maxr2>=0 && reach*reach > maxr2) break;
+        if((int)cand.size()>=k && kth() <= reach*reach) break;
+    }
+    std::sort(cand.begin(), cand.end(),
+        [](const Cand& a, const Cand& b){ return a.d2<b.d2 || (a.d2==b.d2 && a.slot<b.slot); });
+    for(int i=0; i<(int)cand.size() && i<k; ++i) out.push_back(cand[i].slot);
+}
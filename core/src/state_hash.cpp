@@ -0,0 +1,53 @@
+#include "state_hash.hpp"
+#include "sim.hpp"
+
+uint64_t hash_unit(const Unit& u){
+    uint64_t h = hash_mix(0x756e6974ull ^ ((uint64_t)u.id << 8));
+    h = hash_mix(h ^ ((uint64_t)u.type_index | ((uint64_t)u.owner << 16)));
+    h = hash_mix(h ^ hash_pair(u.tile.x, u.tile.y));
+    h = hash_mix(h ^ hash_pair(u.hp, u.carried));
+    h = hash_mix(h ^ ((uint64_t)u.job | ((uint64_t)u.carried_kind << 8) | ((uint64_t)u.cooldown << 16) | ((uint64_t)u.target << 32)));
+    h = hash_mix(h ^ hash_pair(u.goal.x, u.goal.y));
+    return hash_mix(h ^ u.building_target);
+}
+
+uint64_t hash_building(const Building& b){
+    uint64_t h = hash_mix(0x626c6467ull ^ ((uint64_t)b.id << 8));
+    h = hash_mix(h ^ ((uint64_t)b.kind | ((uint64_t)b.state << 8) | ((uint64_t)b.w << 16) | ((uint64_t)b.h << 24) | ((uint64_t)b.owner << 32)));
+    h = hash_mix(h ^ hash_pair(b.tile.x, b.tile.y));
+    h = hash_mix(h ^ hash_pair(b.build_progress_ms, b.build_workers));
+    h = hash_mix(h ^ hash_pair((int32_t)b.build_since_tick, (int32_t)b.train_due_tick));
+    return hash_mix(h ^ hash_pair((int32_t)b.queue.size(), b.queue.empty() ? -1 : b.queue.front().unit_type));
+}
+
+uint64_t hash_tile(const Map& m, int i){
+    uint64_t v = (uint64_t)m.tiles[i] | ((uint64_t)m.blocked[i] << 8);
+    if(i < (int)m.res_kind.size()) v |= ((uint64_t)m.res_kind[i] << 16) | ((uint64_t)(uint32_t)m.res_amount[i] << 24);
+    if(v==0) return 0; // prázdná tráva nepřispívá – přepočet projde jen zajímavé dlaždice
+    return hash_mix(hash_mix(0x74696c65ull ^ ((uint64_t)i << 8)) ^ v);
+}
+
+static uint64_t fold_globals(const Sim& s, uint64_t h){
+    for(size_t p=0;p<s.players.size();++p){
+        const Player& pl = s.players[p];
+        if(p) h = hash_mix(h ^ hash_mix(0x706c6179ull ^ ((uint64_t)p << 8))); // hráč 0 bez značky (otisk jednohráčové hry se nemění)
+        h = hash_mix(h ^ hash_pair(pl.gold, pl.wood));
+        h = hash_mix(h ^ hash_pair(pl.food_used, pl.food_cap));
+    }
+    return hash_mix(h ^ s.tick);
+}
+
+uint64_t state_hash(const Sim& s){ return fold_globals(s, s.hash_acc); }
+
+static uint64_t accumulate(const Sim& s){
+    uint64_t h = 0;
+    for(const auto& u: s.units) h ^= hash_unit(u);
+    for(const auto& b: s.buildings) h ^= hash_building(b);
+    const int n = s.map.width * s.map.height;
+    for(int i=0; i<n && i<(int)s.map.tiles.size(); ++i) h ^= hash_tile(s.map, i);
+    return h;
+}
+
+uint64_t state_hash_full(const Sim& s){ return fold_globals(s, accumulate(s)); }
+
+void rebuild_state_hash(Sim& s){ s.hash_acc = accumulate(s); }
@@ -0,0 +1,47 @@
+#include "timers.hpp"
+
+void timer_reset(TimerWheel& w, uint32_t now){
+    w.now = now;
+    for(auto& lvl: w.slots) for(auto& sl: lvl) sl.clear();
+    w.overflow.clear(); w.ready.clear();
+}
+
+static void place(TimerWheel& w, const TimerEvent& ev){
+    if(ev.due_tick <= w.now){ w.ready.push_back(ev); return; }
+    for(int L=0; L<TimerWheel::kLevels; ++L){
+        int hi = TimerWheel::kBits*(L+1);
+        // stejné bity nad touto úrovní => patří sem
+        if(hi>=32 || (ev.due_tick >> hi) == (w.now >> hi)){
+            w.slots[L][(ev.due_tick >> (TimerWheel::kBits*L)) & (TimerWheel::kSlots-1)].push_back(ev);
+            return;
+        }
+    }
+    w.overflow.push_back(ev);
+}
+
+void timer_schedule(TimerWheel& w, const TimerEvent& ev){ place(w, ev); }
+
+void timer_advance(TimerWheel& w, uint32_t tick, std::vector<TimerEvent>& out){
+    if(!w.ready.empty()){ out.insert(out.end(), w.ready.begin(), w.ready.end()); w.ready.clear(); }
+    std::vector<TimerEvent> tmp;
+    while(w.now < tick){
+        uint32_t t = ++w.now;
+        // při přetečení nižších bitů rozprostři příslušný slot vyšší úrovně (shora dolů)
+        if((t & ((1u << (TimerWheel::kBits*TimerWheel::kLevels)) - 1)) == 0 && !w.overflow.empty()){
+            tmp.swap(w.overflow);
+            for(const auto& ev: tmp) place(w, ev);
+            tmp.clear();
+        }
+        for(int L=TimerWheel::kLevels-1; L>=1; --L){
+            if((t & ((1u << (TimerWheel::kBits*L)) - 1)) != 0) continue;
+            auto& sl = w.slots[L][(t >> (TimerWheel::kBits*L)) & (TimerWheel::kSlots-1)];
+            if(sl.empty()) continue;
+            tmp.swap(sl);
+            for(const auto& ev: tmp) place(w, ev);
+            tmp.clear();
+        }
+        auto& s0 = w.slots[0][t & (TimerWheel::kSlots-1)];
+        if(!s0.empty()){ out.insert(out.end(), s0.begin(), s0.end()); s0.clear(); }
+        if(!w.ready.empty()){ out.insert(out.end(), w.ready.begin(), w.ready.end()); w.ready.clear(); }
+    }
+}
@@ -0,0 +1,313 @@
+// rts_bench – mikro/makro benchmarky vstupních bodů simulace
+//
+//   rts_bench [--assets DIR] [--filter TEXT] [--out FILE] [--baseline FILE] [--threshold PCT]
+//
+// Výstup (stabilní, jeden řádek na benchmark, oddělené tabulátorem):
+//   <name>\t<ns_per_op>\t<ops>
+// --baseline porovná se souborem ve stejném formátu; zpomalení nad práh
+// (výchozí 10 %) označí REGRESSION a vrátí exit kód 1.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sim.hpp"
+#include "data.hpp"
+#include "savegame.hpp"
+#include "pathfinding.hpp"
+#include "mapgen.hpp"
+#include "rng.hpp"
+#include "scenario.hpp"
+
+static const uint32_t kSeed = 12345; // pevný seed všech scénářů
+static const int kReps = 5;          // opakování, bere se medián
+static volatile int g_sink;          // výsledky, které nesmí optimalizátor zahodit
+
+struct Result{ std::string name; double ns_per_op; uint64_t ops; };
+
+struct Bench{
+    std::string filter;
+    std::vector<Result> results;
+
+    bool enabled(const std::string& name) const { return filter.empty() || name.find(filter)!=std::string::npos; }
+
+    // 'body' provede 'ops' operací; volá se kReps krát (po 'setup'), hlásí se medián
+    void run(const std::string& name, uint64_t ops, const std::function<void()>& setup, const std::function<void()>& body){
+        if(!enabled(name)) return;
+        std::vector<double> ns;
+        for(int r=0;r<kReps;++r){
+            if(setup) setup();
+            auto t0 = std::chrono::steady_clock::now();
+            body();
+            ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (double)ops);
+        }
+        std::nth_element(ns.begin(), ns.begin()+ns.size()/2, ns.end());
+        results.push_back({ name, ns[ns.size()/2], ops });
+        std::printf("%s\t%.1f\t%llu\n", name.c_str(), ns[ns.size()/2], (unsigned long long)ops);
+        std::fflush(stdout);
+    }
+};
+
+static bool load_types(Sim& s, const std::string& assets){
+    (void)load_buildings_csv(assets + "/buildings.csv", s.building_types);
+    return load_units_csv(assets + "/units.csv", s.unit_types, s.unit_type_index);
+}
+
+static void make_world(Sim& s, const std::string& assets, int map, int workers, int soldiers, int players=1){
+    s = Sim();
+    load_types(s, assets);
+    set_player_count(s, players);
+    MapGenParams p; p.width = p.height = map; p.seed = kSeed; p.dropoffs = players; // sklad na hráče
+    mapgen_generate(s, p);
+    init_resources_from_tiles(s, 300, 500);
+    scenario_spawn(s, workers, soldiers, kSeed);
+}
+
+static bool write_results(const std::string& path, const std::vector<Result>& rs){
+    std::ofstream f(path, std::ios::trunc);
+    if(!f) return false;
+    for(const auto& r: rs){
+        char buf[64]; std::snprintf(buf, sizeof(buf), "%.1f", r.ns_per_op);
+        f << r.name << "\t" << buf << "\t" << r.ops << "\n";
+    }
+    return (bool)f;
+}
+
+static bool read_results(const std::string& path, std::map<std::string, double>& out){
+    std::ifstream f(path);
+    if(!f) return false;
+    std::string line;
+    while(std::getline(f, line)){
+        std::istringstream ss(line);
+        std::string name; double ns=0;
+        if(std::getline(ss, name, '\t') && ss >> ns) out[name] = ns;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    std::string assets = "assets", out_path, baseline_path;
+    double threshold = 10.0;
+    Bench b;
+    for(int i=1;i<argc;++i){
+        auto arg = [&](const char* name){ return std::strcmp(argv[i], name)==0 && i+1<argc; };
+        if(arg("--assets"))         assets = argv[++i];
+        else if(arg("--filter"))    b.filter = argv[++i];
+        else if(arg("--out"))       out_path = argv[++i];
+        else if(arg("--baseline"))  baseline_path = argv[++i];
+        else if(arg("--threshold")) threshold = std::atof(argv[++i]);
+        else { std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return 2; }
+    }
+    { Sim probe; if(!load_types(probe, assets)){ std::fprintf(stderr, "Failed to load %s/units.csv\n", assets.c_str()); return 3; } }
+
+    Sim s;
+
+    // --- step: polovina dělníků, polovina vojáků ve dvou armádách
+    const int step_units[] = { 100, 1000, 10000 };
+    for(int n: step_units){
+        const int map = n>=10000 ? 512 : 256;
+        const uint64_t ticks = n>=10000 ? 10 : 100, warmup = n>=10000 ? 5 : 20;
+        b.run("step/units=" + std::to_string(n), ticks,
+            [&]{ make_world(s, assets, map, n/2, n - n/2); for(uint64_t i=0;i<warmup;++i) step(s, 50); },
+            [&]{ for(uint64_t i=0;i<ticks;++i) step(s, 50); });
+    }
+    // 8 hráčů se stejným počtem jednotek: dělníci na 8 základnách, vojáci 8 vlastníků
+    b.run("step/players=8/units=1000", 100,
+        [&]{ make_world(s, assets, 256, 500, 500, 8); for(int i=0;i<20;++i) step(s, 50); },
+        [&]{ for(int i=0;i<100;++i) step(s, 50); });
+
+    // --- order_gather na vytěženou dlaždici -> find_nearest_resource přes celou mapu
+    const int gather_maps[] = { 64, 256, 512 };
+    for(int map: gather_maps){
+        const uint64_t ops = 200;
+        Vec2i depleted{-1,-1};
+        b.run("order_gather/map=" + std::to_string(map), ops,
+            [&]{
+                make_world(s, assets, map, 1, 0);
+                // první zlatá dlaždice jako "vytěžená" (res_kind zůstává)
+                depleted = {-1,-1};
+                for(int i=0;i<map*map && depleted.x<0;++i) if(s.map.res_kind[i]==(uint8_t)ResourceKind::Gold){ MapEdit e; e.layers=kLayerResAmount; map_apply(s, i, e); depleted={i%map, i/map}; }
+            },
+            [&]{ for(uint64_t i=0;i<ops;++i) order_gather(s, s.units[0].id, depleted.x, depleted.y); });
+    }
+
+    // --- nearest_dropoff při různém počtu skladů
+    const int drop_counts[] = { 1, 16, 256 };
+    for(int nd: drop_counts){
+        const uint64_t ops = 100000;
+        std::vector<Vec2i> q;
+        b.run("nearest_dropoff/dropoffs=" + std::to_string(nd), ops,
+            [&]{
+                s = Sim(); RNG rng(kSeed);
+                for(int i=0;i<nd;++i) s.players[0].dropoffs.push_back({ (int)rng.next_range(256), (int)rng.next_range(256) });
+                q.clear(); for(int i=0;i<1024;++i) q.push_back({ (int)rng.next_range(256), (int)rng.next_range(256) });
+            },
+            [&]{ int acc=0; for(uint64_t i=0;i<ops;++i) acc += nearest_dropoff(s, 0, q[i & 1023]).x; if(acc==-1) std::puts(""); });
+    }
+
+    // --- can_place_building
+    {
+        const uint64_t ops = 200000;
+        std::vector<Vec2i> q;
+        b.run("can_place_building/map=256", ops,
+            [&]{
+                make_world(s, assets, 256, 0, 0);
+                RNG rng(kSeed); q.clear();
+                for(int i=0;i<1024;++i) q.push_back({ (int)rng.next_range(256), (int)rng.next_range(256) });
+            },
+            [&]{
+                const BuildingType& bt = get_btype(s, BuildingKind::Barracks); int acc=0;
+                for(uint64_t i=0;i<ops;++i) acc += can_place_building(s, bt, q[i & 1023].x, q[i & 1023].y);
+                if(acc==-1) std::puts("");
+            });
+    }
+
+    // --- save_game / load_game
+    const int save_maps[] = { 64, 256, 512 };
+    for(int map: save_maps){
+        const std::string path = "rts_bench_save.tmp";
+        b.run("save_game/map=" + std::to_string(map), 1,
+            [&]{ make_world(s, assets, map, 100, 100); },
+            [&]{ save_game(s, path); });
+        Sim ld;
+        b.run("load_game/map=" + std::to_string(map), 1,
+            [&]{ make_world(s, assets, map, 100, 100); save_game(s, path); ld = Sim(); load_types(ld, assets); },
+            [&]{ load_game(ld, path); });
+        // autosave jako delta proti keyframe po 20 tickách hry
+        SaveChain chain;
+        b.run("save_game_delta/map=" + std::to_string(map), 1,
+            [&]{ make_world(s, assets, map, 100, 100); chain = SaveChain(); save_game_chain(s, chain, path); for(int i=0;i<20;++i) step(s, 50); },
+            [&]{ save_game_chain(s, chain, path); });
+        for(const char* k: { ".k0", ".k1" }) std::remove((path + k).c_str());
+        // textový VERSION 1 pro srovnání
+        b.run("save_game_text/map=" + std::to_string(map), 1,
+            [&]{ make_world(s, assets, map, 100, 100); },
+            [&]{ save_game_text(s, path); });
+        b.run("load_game_text/map=" + std::to_string(map), 1,
+            [&]{ make_world(s, assets, map, 100, 100); save_game_text(s, path); ld = Sim(); load_types(ld, assets); },
+            [&]{ load_game(ld, path); });
+        std::remove(path.c_str());
+    }
+
+    // --- rozložení Map::walk: A* a obdélníkové dotazy nad stejnou mapou
+    const GridLayout layouts[] = { GridLayout::RowMajor, GridLayout::Block, GridLayout::Morton };
+    for(GridLayout l: layouts){
+        const int map = 1024;
+        const uint64_t ops = 200;
+        std::vector<std::pair<Vec2i,Vec2i>> q;
+        std::vector<Vec2i> path;
+        auto free_tile = [&](RNG& rng){
+            for(;;){ Vec2i p{ (int)rng.next_range(map), (int)rng.next_range(map) }; if(s.map.walk[s.map.walk_ix(p.x,p.y)]) return p; }
+        };
+        b.run(std::string("astar/layout=") + grid_layout_name(l) + "/map=1024", ops,
+            [&]{
+                make_world(s, assets, map, 0, 0); map_set_layout(s.map, l);
+                RNG rng(kSeed); q.clear();
+                for(uint64_t i=0;i<ops;++i){
+                    Vec2i a = free_tile(rng), c = free_tile(rng);
+                    c.x = a.x + (c.x - a.x)/8; c.y = a.y + (c.y - a.y)/8;
+                    if(!s.map.walk[s.map.walk_ix(c.x,c.y)]) c = a;
+                    q.push_back({a,c});
+                }
+            },
+            [&]{ for(const auto& p: q) astar_find(s.map, p.first, p.second, path, true, 1<<20); });
+        std::vector<Vec2i> rq;
+        b.run(std::string("region_query/layout=") + grid_layout_name(l) + "/map=1024", 20000,
+            [&]{ make_world(s, assets, map, 0, 0); map_set_layout(s.map, l); RNG rng(kSeed); rq.clear();
+                 for(int i=0;i<1024;++i) rq.push_back({ (int)rng.next_range(map-32), (int)rng.next_range(map-32) }); },
+            [&]{
+                // průchodné dlaždice v okně 32x32 (ozn. placement / hustota pro AI)
+                int acc=0;
+                for(int i=0;i<20000;++i){ Vec2i o = rq[i & 1023];
+                    for(int y=o.y;y<o.y+32;++y) for(int x=o.x;x<o.x+32;++x) acc += s.map.walk[s.map.walk_ix(x,y)]; }
+                g_sink += acc;
+            });
+    }
+
+    // --- načítání dat
+    {
+        const uint64_t ops = 200;
+        b.run("load_units_csv", ops, nullptr, [&]{
+            for(uint64_t i=0;i<ops;++i){
+                std::vector<UnitType> t; NameIndex ix;
+                load_units_csv(assets + "/units.csv", t, ix);
+            }
+        });
+        // mod pack: tisíce typů jednotek
+        const std::string csv_path = "rts_bench_units.tmp";
+        {
+            std::ofstream f(csv_path, std::ios::trunc);
+            f << "id,hp,move_px_s,attackType,damage,cooldown_ms,range_tiles,armorType,armor,sight,cost_gold,cost_wood,food,build_time_ms\n";
+            for(int i=0;i<5000;++i) f << "unit" << i << "," << 50+i%100 << ",120,Pierce," << 5+i%20 << ",800,1,Heavy,1,6,100,20,1,2000\n";
+        }
+        b.run("load_units_csv/types=5000", 1, nullptr, [&]{
+            std::vector<UnitType> t; NameIndex ix;
+            load_units_csv(csv_path, t, ix); g_sink = (int)t.size();
+        });
+        {
+            std::vector<UnitType> t; NameIndex ix;
+            load_units_csv(csv_path, t, ix);
+            b.run("unit_type_id/types=5000", t.size(), nullptr, [&]{
+                int sum = 0; for(const auto& u: t) sum += ix.find(u.id); g_sink = sum;
+            });
+        }
+        std::remove(csv_path.c_str());
+        b.run("load_map_txt/assets", ops, nullptr, [&]{
+            for(uint64_t i=0;i<ops;++i){ Map m; load_map_txt(assets + "/map.txt", m); }
+        });
+        // větší mapa zapsaná z generátoru ve formátu map.txt
+        const std::string path = "rts_bench_map.tmp", bin_path = "rts_bench_map.rtsmap";
+        for(int n: {512, 4096}){
+            const std::string sz = "/map=" + std::to_string(n);
+            if(!b.enabled("load_map_txt" + sz) && !b.enabled("load_map_bin" + sz)) continue;
+            Sim g; scenario_generate_map(g, n, n, kSeed);
+            save_map_txt(g.map, path);
+            save_map_bin(g.map, bin_path, 300, 500);
+            // text: parsování + sken skladů + init_resources_from_tiles; kompilovaná: vše předpočítané
+            b.run("load_map_txt" + sz, 1, nullptr, [&]{
+                Sim t; load_map_txt(path, t.map);
+                for(int y=0;y<n;++y) for(int x=0;x<n;++x) if(t.map.tiles[(size_t)y*n+x]==4) t.players[0].dropoffs.push_back({x,y});
+                init_resources_from_tiles(t, 300, 500);
+            });
+            b.run("load_map_bin" + sz, 1, nullptr, [&]{
+                Sim t; load_map_bin(bin_path, t.map, t.players[0].dropoffs);
+                map_touch_all(t.map);
+            });
+        }
+        std::remove(path.c_str()); std::remove(bin_path.c_str());
+    }
+
+    // --- generátor map
+    for(int n: {1024, 8192}){
+        MapGenParams p; p.width = p.height = n; p.seed = kSeed; p.maze_cell = 24; p.dropoffs = 4;
+        b.run("mapgen/maze/map=" + std::to_string(n), 1, nullptr, [&]{ Sim g; mapgen_generate(g, p); g_sink = g.map.tiles[(size_t)n*n/2]; });
+    }
+
+    if(!out_path.empty() && !write_results(out_path, b.results)){
+        std::fprintf(stderr, "Failed to write %s\n", out_path.c_str()); return 3;
+    }
+
+    if(!baseline_path.empty()){
+        std::map<std::string, double> base;
+        if(!read_results(baseline_path, base)){ std::fprintf(stderr, "Failed to read baseline %s\n", baseline_path.c_str()); return 3; }
+        int regressions = 0;
+        std::printf("\n%-36s %12s %12s %8s\n", "benchmark", "baseline", "current", "delta");
+        for(const auto& r: b.results){
+            auto it = base.find(r.name);
+            if(it==base.end() || it->second<=0){ std::printf("%-36s %12s %12.1f %8s\n", r.name.c_str(), "-", r.ns_per_op, "new"); continue; }
+            double pct = (r.ns_per_op - it->second) * 100.0 / it->second;
+            bool bad = pct > threshold;
+            regressions += bad;
+            std::printf("%-36s %12.1f %12.1f %+7.1f%%%s\n", r.name.c_str(), it->second, r.ns_per_op, pct, bad ? "  REGRESSION" : "");
+        }
+        std::printf("%d regression(s) over %.1f%%\n", regressions, threshold);
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
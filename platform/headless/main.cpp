@@ -0,0 +1,160 @@
+// rts_headless – běh simulace bez SDL (měření propustnosti, přehrávání záznamů)
+//
+//   rts_headless [--assets DIR] [--gen W H] [--maze CELL] [--dropoffs N] [--players N] [--workers N]
+//                [--soldiers N] [--builders N] [--ticks M] [--seed S] [--replay FILE] [--trace FILE] [--hash]
+//
+// --hash vypíše jen hash stavu – výstupy dvou buildů (-O0 vs -O3 -ffast-math) jdou porovnat přímo.
+// --players N (1..8): s --gen má každý hráč aspoň jeden sklad a vlastní dělníky a ekonomiku.
+// --builders N: u každé základny N stavitelů staví kasárna a farmu, kasárna pak cvičí.
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sim.hpp"
+#include "data.hpp"
+#include "commands.hpp"
+#include "state_hash.hpp"
+#include "scenario.hpp"
+#include "prof.hpp"
+#include "mapgen.hpp"
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+static size_t peak_rss_kb(){
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+  #ifdef __APPLE__
+    return (size_t)ru.ru_maxrss / 1024; // bajty
+  #else
+    return (size_t)ru.ru_maxrss;        // kB
+  #endif
+#endif
+}
+
+struct Options{
+    std::string assets = "assets";
+    int gen_w = 0, gen_h = 0;  // 0 = map.txt z assets
+    int maze = 0, dropoffs = 1; // mapgen: rozteč zdí bludiště, počet skladů
+    int players = 1;
+    int workers = 200, soldiers = 400, builders = 0;
+    uint32_t ticks = 6000;
+    uint32_t seed = 1;
+    std::string replay;
+    std::string trace; // Chrome trace (jen s RTS_PROFILE)
+    bool hash_only = false;
+};
+
+static bool parse_args(int argc, char** argv, Options& o){
+    for(int i=1;i<argc;++i){
+        auto arg = [&](const char* name){ return std::strcmp(argv[i], name)==0 && i+1<argc; };
+        if(arg("--assets"))        o.assets = argv[++i];
+        else if(arg("--workers"))  o.workers = std::atoi(argv[++i]);
+        else if(arg("--soldiers")) o.soldiers = std::atoi(argv[++i]);
+        else if(arg("--builders")) o.builders = std::atoi(argv[++i]);
+        else if(arg("--ticks"))    o.ticks = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if(arg("--maze"))     o.maze = std::atoi(argv[++i]);
+        else if(arg("--dropoffs")) o.dropoffs = std::atoi(argv[++i]);
+        else if(arg("--players"))  o.players = std::atoi(argv[++i]);
+        else if(arg("--seed"))     o.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if(arg("--replay"))   o.replay = argv[++i];
+        else if(arg("--trace"))    o.trace = argv[++i];
+        else if(std::strcmp(argv[i], "--hash")==0) o.hash_only = true;
+        else if(std::strcmp(argv[i], "--gen")==0 && i+2<argc){ o.gen_w = std::atoi(argv[++i]); o.gen_h = std::atoi(argv[++i]); }
+        else { std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return false; }
+    }
+    return true;
+}
+
+static double percentile(std::vector<double> v, double p){
+    if(v.empty()) return 0.0;
+    size_t k = (size_t)(p * (v.size()-1));
+    std::nth_element(v.begin(), v.begin()+k, v.end());
+    return v[k];
+}
+
+static void write_trace(const Options& o){
+    if(o.trace.empty()) return;
+    if(!prof_enabled()) std::fprintf(stderr, "--trace: rts_core built without RTS_PROFILE\n");
+    else if(prof_dump_chrome(o.trace)) std::printf("trace: %s\n", o.trace.c_str());
+}
+
+int main(int argc, char** argv){
+    Options o;
+    if(!parse_args(argc, argv, o)) return 2;
+
+    Sim sim;
+    const uint32_t dt = 1000 / sim.cfg.tick_rate;
+
+    if(!o.replay.empty()){
+        CommandLog log;
+        if(!load_command_log(log, o.replay)){ std::fprintf(stderr, "Failed to load replay %s\n", o.replay.c_str()); return 3; }
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = replay_run(sim, log, dt);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if(o.hash_only){ std::printf("%016" PRIx64 "\n", state_hash(sim)); return ok ? 0 : 1; }
+        std::printf("replay: %zu commands, %u ticks in %.1f ms (%.0f ticks/s), hash %016" PRIx64 " %s\n",
+            log.cmds.size(), sim.tick, ms, ms>0 ? sim.tick*1000.0/ms : 0.0, state_hash(sim),
+            log.end_hash==0 ? "(unverified)" : ok ? "OK" : "MISMATCH");
+        std::printf("peak RSS: %zu kB\n", peak_rss_kb());
+        write_trace(o);
+        return ok ? 0 : 1;
+    }
+
+    if(!set_player_count(sim, o.players)){ std::fprintf(stderr, "--players: must be 1..%d\n", kMaxPlayers); return 2; }
+    if(o.gen_w>0 && o.gen_h>0){
+        if(!load_units_csv(o.assets + "/units.csv", sim.unit_types, sim.unit_type_index)){
+            std::fprintf(stderr, "Failed to load %s/units.csv\n", o.assets.c_str()); return 3;
+        }
+        (void)load_buildings_csv(o.assets + "/buildings.csv", sim.building_types);
+        MapGenParams p; p.width = o.gen_w; p.height = o.gen_h; p.seed = o.seed; p.maze_cell = o.maze; p.dropoffs = std::max(o.dropoffs, o.players);
+        if(!mapgen_generate(sim, p)){ std::fprintf(stderr, "--gen: map size must be 1..%d\n", kMapGenMaxSize); return 2; }
+    }else if(!load_data(sim, o.assets)){
+        std::fprintf(stderr, "Failed to load assets from %s\n", o.assets.c_str()); return 3;
+    }
+    if(sim.map.res_kind.empty()) init_resources_from_tiles(sim, 300, 500);
+    scenario_spawn(sim, o.workers, o.soldiers, o.seed);
+    scenario_build(sim, o.builders, o.seed);
+
+    size_t map_edits = 0;
+    map_subscribe(sim, [&](const Sim&, const std::vector<MapChange>& ch){ for(const auto& c: ch) map_edits += c.i>=0; });
+
+    std::vector<double> tick_us; tick_us.reserve(o.ticks);
+    auto t0 = std::chrono::steady_clock::now();
+    for(uint32_t i=0;i<o.ticks;++i){
+        auto a = std::chrono::steady_clock::now();
+        step(sim, dt);
+        tick_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - a).count());
+    }
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if(o.hash_only){ std::printf("%016" PRIx64 "\n", state_hash(sim)); return 0; }
+
+    std::printf("map %dx%d, %zu units, %u ticks in %.1f ms\n", sim.map.width, sim.map.height, sim.units.size(), o.ticks, total_ms);
+    std::printf("map edits: %zu\n", map_edits);
+    std::printf("ticks/s: %.0f\n", total_ms>0 ? o.ticks*1000.0/total_ms : 0.0);
+    std::printf("tick us: p50 %.1f  p99 %.1f  max %.1f\n", percentile(tick_us, 0.50), percentile(tick_us, 0.99),
+        tick_us.empty() ? 0.0 : *std::max_element(tick_us.begin(), tick_us.end()));
+    std::printf("peak RSS: %zu kB\n", peak_rss_kb());
+    for(size_t p=0;p<sim.players.size();++p){
+        const Player& pl = sim.players[p];
+        std::printf("player %zu: %zu units, %zu buildings, gold %d, wood %d, food %d/%d\n", p, pl.units.size(),
+            pl.buildings.size(), pl.gold, pl.wood, pl.food_used, pl.food_cap);
+    }
+    std::printf("state hash: %016" PRIx64 "\n", state_hash(sim));
+    write_trace(o);
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "scenario.hpp"
+#include "commands.hpp"
+#include "rng.hpp"
+#include "mapgen.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+void scenario_generate_map(Sim& s, int w, int h, uint32_t seed){
+    MapGenParams p; p.width = w; p.height = h; p.seed = seed;
+    mapgen_generate(s, p);
+}
+
+static Vec2i free_tile_near(const Sim& s, Vec2i c, RNG& rng){
+    for(int tries=0; tries<64; ++tries){
+        int r = 2 + tries/4;
+        int x = c.x + (int)rng.next_range(2*r+1) - r, y = c.y + (int)rng.next_range(2*r+1) - r;
+        if(x<0 || y<0 || x>=s.map.width || y>=s.map.height) continue;
+        size_t i = (size_t)y*s.map.width+x;
+        if(s.map.tiles[i]==0 && !s.map.blocked[i]) return {x,y};
+    }
+    return c;
+}
+
+// Základna hráče: první sklad a nejbližší zlato / les k němu (dělníci pak přecházejí sami).
+struct Base{ uint8_t owner; Vec2i d; Vec2i near_res[2]; };
+
+static Base find_base(const Sim& s, uint8_t owner, Vec2i d){
+    Base b{ owner, d, {{-1,-1},{-1,-1}} }; int best[2] = {1<<30, 1<<30};
+    for(int y=0;y<s.map.height;++y) for(int x=0;x<s.map.width;++x){
+        uint8_t t = s.map.tiles[(size_t)y*s.map.width+x];
+        if(t!=2 && t!=3) continue;
+        int k = t==2 ? 0 : 1, dd = std::abs(x-d.x)+std::abs(y-d.y);
+        if(dd<best[k]){ best[k]=dd; b.near_res[k]={x,y}; }
+    }
+    return b;
+}
+
+void scenario_spawn(Sim& s, int workers, int soldiers, uint32_t seed){
+    RNG rng(seed*7919u + 1);
+    std::vector<Base> bases;
+    for(size_t p=0;p<s.players.size();++p)
+        if(!s.players[p].dropoffs.empty()) bases.push_back(find_base(s, (uint8_t)p, s.players[p].dropoffs[0]));
+    if(bases.empty()) bases.push_back(find_base(s, 0, {1,1}));
+    const UnitTypeId footman = unit_type_id(s, "footman"), archer = unit_type_id(s, "archer");
+    for(int i=0;i<workers;++i){
+        const Base& b = bases[i % bases.size()];
+        Vec2i t = free_tile_near(s, b.d, rng);
+        UnitId id = spawn_unit(s, footman, t.x, t.y, b.owner);
+        Vec2i res = b.near_res[(i / bases.size())%3==0 ? 0 : 1];
+        if(res.x<0) continue;
+        Command c; c.type=CmdType::Gather; c.unit=id; c.x=res.x; c.y=res.y; c.player=b.owner;
+        apply_command(s, c);
+    }
+    Vec2i left{ s.map.width/6, s.map.height/2 }, right{ s.map.width - 1 - s.map.width/6, s.map.height/2 };
+    const int sides = std::max<int>(2, (int)s.players.size());
+    for(int i=0;i<soldiers;++i){
+        uint8_t owner = (uint8_t)(i % sides);
+        Vec2i from = (owner&1) ? right : left, to = (owner&1) ? left : right;
+        Vec2i t = free_tile_near(s, from, rng);
+        UnitId id = spawn_unit(s, i%3 ? footman : archer, t.x, t.y, owner);
+        Command c; c.type=CmdType::Move; c.unit=id; c.x=(from.x+to.x)/2; c.y=to.y; c.player=owner;
+        apply_command(s, c);
+    }
+}
+
+static Vec2i place_near(const Sim& s, const BuildingType& bt, Vec2i c){
+    for(int r=3; r<32; ++r) for(int dy=-r; dy<=r; ++dy) for(int dx=-r; dx<=r; ++dx)
+        if(std::max(std::abs(dx), std::abs(dy))==r && can_place_building(s, bt, c.x+dx, c.y+dy)) return {c.x+dx, c.y+dy};
+    return {-1,-1};
+}
+
+void scenario_build(Sim& s, int builders, uint32_t seed){
+    RNG rng(seed*104729u + 7);
+    const UnitTypeId footman = unit_type_id(s, "footman");
+    if(builders<=0 || footman==kNoUnitType) return;
+    const UnitType& ft = s.unit_types[footman];
+    const BuildingType& bar = get_btype(s, BuildingKind::Barracks);
+    const BuildingType& farm = get_btype(s, BuildingKind::Farm);
+    const int trained = 3;
+    for(size_t p=0;p<s.players.size();++p){
+        if(s.players[p].dropoffs.empty()) continue;
+        const uint8_t owner = (uint8_t)p;
+        const Vec2i d = s.players[p].dropoffs[0];
+        Player& pl = s.players[p];
+        pl.gold += bar.cost_gold + farm.cost_gold + trained*ft.cost_gold;
+        pl.wood += bar.cost_wood + farm.cost_wood + trained*ft.cost_wood;
+        auto cmd = [&](CmdType t, UnitId u, int x, int y, uint32_t arg){
+            Command c; c.type=t; c.unit=u; c.x=x; c.y=y; c.arg=arg; c.player=owner;
+            return apply_command(s, c);
+        };
+        const Vec2i at_bar = place_near(s, bar, d);
+        const BuildingId b = at_bar.x<0 ? 0 : cmd(CmdType::PlaceBuilding, 0, at_bar.x, at_bar.y, (uint32_t)BuildingKind::Barracks);
+        const Vec2i at_farm = place_near(s, farm, d);
+        const BuildingId f = at_farm.x<0 ? 0 : cmd(CmdType::PlaceBuilding, 0, at_farm.x, at_farm.y, (uint32_t)BuildingKind::Farm);
+        for(int i=0;i<builders;++i){
+            Vec2i t = free_tile_near(s, d, rng);
+            UnitId id = spawn_unit(s, footman, t.x, t.y, owner);
+            const BuildingId target = i+1<builders || builders==1 ? b : f;
+            if(target) cmd(CmdType::Build, id, 0, 0, target);
+        }
+        if(b){ cmd(CmdType::Train, 0, footman, trained, b); cmd(CmdType::SetRally, 0, d.x, d.y, b); }
+    }
+}
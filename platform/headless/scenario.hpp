@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include "sim.hpp"
+
+// Společné scénáře pro rts_headless a rts_bench (deterministické podle seedu).
+
+// Tráva, náhodné shluky lesa a zlata, sklad uprostřed (mapgen s výchozími parametry). Nastaví i sklady hráčů.
+void scenario_generate_map(Sim& s, int w, int h, uint32_t seed);
+
+// Dělníci se rozdělí mezi hráče se skladem a těží kolem jeho prvního skladu; vojáci
+// (vlastník i % max(2, hráčů)) jdou ze dvou stran proti sobě.
+void scenario_spawn(Sim& s, int workers, int soldiers, uint32_t seed);
+
+// Stavba u každé základny: kasárna (všichni 'builders' kromě posledního) a farma
+// (poslední), v kasárnách fronta výcviku už během stavby. Cenu budov a výcviku
+// hráč dostane navíc, aby scénář nezávisel na vytěžených surovinách.
+void scenario_build(Sim& s, int builders, uint32_t seed);
@@ -0,0 +1,62 @@
+// rts_mapc – převod map.txt na kompilovanou mapu (.rtsmap) pro rychlé load_data()
+//
+//   rts_mapc IN.txt OUT.rtsmap [--wood N] [--gold N]
+//   rts_mapc --gen W H [--seed S] [--maze CELL] [--dropoffs N] OUT [--wood N] [--gold N]
+//
+// OUT s příponou .txt se zapíše ve formátu map.txt (jen s --gen), jinak .rtsmap.
+// --wood/--gold: zásoba na dlaždici lesa/zlata (výchozí 300/500 jako hra).
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sim.hpp"
+#include "data.hpp"
+#include "mapgen.hpp"
+
+int main(int argc, char** argv){
+    std::vector<std::string> files;
+    int wood = 300, gold = 500;
+    MapGenParams p; p.width = p.height = 0;
+    for(int i=1;i<argc;++i){
+        auto arg = [&](const char* name){ return std::strcmp(argv[i], name)==0 && i+1<argc; };
+        if(arg("--wood"))      wood = std::atoi(argv[++i]);
+        else if(arg("--gold")) gold = std::atoi(argv[++i]);
+        else if(arg("--seed")) p.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if(arg("--maze")) p.maze_cell = std::atoi(argv[++i]);
+        else if(arg("--dropoffs")) p.dropoffs = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--gen")==0 && i+2<argc){ p.width = std::atoi(argv[++i]); p.height = std::atoi(argv[++i]); }
+        else if(argv[i][0]=='-'){ std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return 2; }
+        else files.push_back(argv[i]);
+    }
+    const bool gen = p.width!=0 || p.height!=0;
+    if(files.size() != (gen ? 1u : 2u)){
+        std::fprintf(stderr, "usage: rts_mapc IN.txt OUT.rtsmap [--wood N] [--gold N]\n"
+                             "       rts_mapc --gen W H [--seed S] [--maze CELL] [--dropoffs N] OUT [--wood N] [--gold N]\n");
+        return 2;
+    }
+
+    Sim s;
+    auto t0 = std::chrono::steady_clock::now();
+    if(gen){
+        if(!mapgen_generate(s, p)){ std::fprintf(stderr, "--gen: map size must be 1..%d\n", kMapGenMaxSize); return 2; }
+    }else if(!load_map_txt(files[0], s.map)){ std::fprintf(stderr, "Failed to load %s\n", files[0].c_str()); return 3; }
+    const std::string& out = files.back();
+    if(gen && out.size()>4 && out.compare(out.size()-4, 4, ".txt")==0){
+        if(!save_map_txt(s.map, out)){ std::fprintf(stderr, "Failed to write %s\n", out.c_str()); return 3; }
+        std::printf("%s: %dx%d, %zu dropoffs\n", out.c_str(), s.map.width, s.map.height, s.players[0].dropoffs.size());
+        return 0;
+    }
+    MapSource src; // load_data() pozná .rtsmap zastaralý proti map.txt
+    if(!gen && !map_source_of(files[0], &src)){ std::fprintf(stderr, "Failed to read %s\n", files[0].c_str()); return 3; }
+    if(!save_map_bin(s.map, out, wood, gold, src)){ std::fprintf(stderr, "Failed to write %s\n", out.c_str()); return 3; }
+    auto t1 = std::chrono::steady_clock::now();
+
+    Map m; std::vector<Vec2i> drops;
+    if(!load_map_bin(out, m, drops) || m.tiles != s.map.tiles){ std::fprintf(stderr, "Verification of %s failed\n", out.c_str()); return 1; }
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+    std::printf("%s: %dx%d, %zu dropoffs, compiled in %.1f ms, loads in %.1f ms\n", out.c_str(), m.width, m.height, drops.size(),
+        std::chrono::duration<double, std::milli>(t1 - t0).count(), load_ms);
+    return 0;
+}
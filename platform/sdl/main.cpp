@@ -8,6 +8,11 @@
 #include <SDL_ttf.h>
 #include "sim.hpp"
 #include "pathfinding.hpp"
+#include "combat.hpp"
+#include "commands.hpp"
+#include "state_hash.hpp"
+#include "prof.hpp"
+#include "async_save.hpp"
 
 
 static void draw_text(SDL_Renderer* ren, TTF_Font* font,
@@ -71,6 +76,8 @@ static const int UNIT_H = 40;
 static int ORIGIN_X = 260;
 static int ORIGIN_Y = 120;
 
+static const int LOCAL_PLAYER = 0; // čí fog-of-war se kreslí
+
 static bool g_minimapDragging = false;
 
 // camera pixel offset
@@ -111,6 +118,23 @@ static inline Vec2i screen_px_to_iso(int sx,int sy){
     return {tx, ty};
 }
 
+// Kandidáti pro picking: sloty jednotek, jejichž sprite může zasahovat do 'rw' (world px).
+// Obdélník se rozšíří o rozměr spritu, převede na dlaždice a dotáže se unit_grid.
+static void units_near_screen_rect(const Sim& sim, SDL_Rect rw, std::vector<uint32_t>& out){
+    int x0 = rw.x - UNIT_W/2, x1 = rw.x + rw.w + UNIT_W/2;
+    int y0 = rw.y - ISO_H/2,  y1 = rw.y + rw.h + UNIT_H - ISO_H/2;
+    const Vec2i c[4] = { screen_px_to_iso(x0,y0), screen_px_to_iso(x1,y0),
+                         screen_px_to_iso(x0,y1), screen_px_to_iso(x1,y1) };
+    int tx0=c[0].x, tx1=c[0].x, ty0=c[0].y, ty1=c[0].y;
+    for(const auto& t: c){
+        tx0=std::min(tx0,t.x); tx1=std::max(tx1,t.x);
+        ty0=std::min(ty0,t.y); ty1=std::max(ty1,t.y);
+    }
+    out.clear();
+    spatial_query_rect(sim.unit_grid, sim.units, tx0-1, ty0-1, tx1+1, ty1+1, out);
+    std::sort(out.begin(), out.end()); // zachovej pořadí jako při průchodu sim.units
+}
+
 static void clamp_camera(const Sim& sim){
     int world_w = (sim.map.width + sim.map.height) * (ISO_W/2);
     int world_h = (sim.map.width + sim.map.height) * (ISO_H/2);
@@ -154,7 +178,6 @@ static void draw_number(SDL_Renderer* r, int x, int y, int v){
     for(int i=0;i<n;++i){ draw_digit(r, x+(n-1-i)*10, y, digits[n-1-i]); }
 }
 
-static inline int idx(int w, int x, int y){ return y*w + x; }
 // ---------- Command card buttons ----------
 
 struct Btn {
@@ -416,7 +439,20 @@ int main(int argc, char** argv){
         std::fprintf(stderr, "Failed to load assets.\n"); return 3;
     }
 
-    init_resources_from_tiles(sim, /*wood*/300, /*gold*/500);
+    if(sim.map.res_kind.empty()) init_resources_from_tiles(sim, /*wood*/300, /*gold*/500); // map.rtsmap je má v sobě
+
+    // záznam příkazů od počátečního stavu -> replay.txt (po F9 load už neplatí)
+    CommandLog replay; replay.assets = "assets"; replay.wood_amount = 300; replay.gold_amount = 500;
+    replay.players = (int)sim.players.size();
+    bool recording = true;
+    auto cmd = [&](CmdType type, UnitId unit, int x, int y, uint32_t arg)->uint32_t{
+        Command c; c.type=type; c.unit=unit; c.x=x; c.y=y; c.arg=arg; c.player=LOCAL_PLAYER;
+        return submit_command(sim, recording ? &replay : nullptr, c);
+    };
+    const UnitTypeId footman = unit_type_id(sim, "footman"); // typy se po F9 nemění
+    auto train_cmd = [&](const Building& b, UnitTypeId type, int count){
+        if(type!=kNoUnitType) cmd(CmdType::Train, 0, type, count, b.id);
+    };
 
     const double TICK = 1.0 / (double)sim.cfg.tick_rate;
     uint64_t last = now_us(); double acc=0.0;
@@ -427,6 +463,8 @@ int main(int argc, char** argv){
     static bool     draggingLocal = false;
 
     HudNotice hud{};
+    AsyncSaver saver; // savy se zapisují na pozadí, výsledek hlásí HUD
+    enum { kSaveManual=1, kSaveAuto=2 };
 
     uint32_t autosave_period_ms = 5 * 60 * 1000; // 5 minut
     uint32_t next_autosave_ms   = SDL_GetTicks() + autosave_period_ms;
@@ -497,20 +535,6 @@ int main(int argc, char** argv){
         return false;
     };
 
-    auto relax_builders = [&](Sim& s){
-        for(auto& u : s.units){
-            if(u.type_index!=0) continue;            // jen dělníci
-            if(u.job != UnitJob::Building) continue;
-
-            Building* tb = find_building(s, u.building_target);
-            if(!tb || tb->state == BuildState::Complete){
-                u.job = UnitJob::Idle;
-                u.building_target = 0;
-                u.path.clear();
-            }
-        }
-    };
-
     auto world_viewport = [&](){
         SDL_Rect r{0, 0, WINDOW_W, WINDOW_H};
 
@@ -525,10 +549,16 @@ int main(int argc, char** argv){
     };
 
     while(running){
+        RTS_PROF_SCOPE("frame");
+        RTS_PROF_BEGIN(events, "frame.events");
         SDL_Event e;
         while(SDL_PollEvent(&e)){
             if(e.type==SDL_QUIT){
-                save_game(sim, "autosave.txt");
+                async_save_request(saver, sim, "autosave.sav", kSaveAuto, true); // dokončí se před koncem main()
+                if(recording){
+                    replay.end_tick = sim.tick; replay.end_hash = state_hash(sim);
+                    if(save_command_log(replay, "replay.txt")) std::printf("[REPLAY] %zu commands -> replay.txt\n", replay.cmds.size());
+                }
                 running=false;
             }
             if(e.type==SDL_KEYDOWN){
@@ -538,18 +568,27 @@ int main(int argc, char** argv){
                 if(e.key.keysym.sym==SDLK_w) cam_py -= 12;
                 if(e.key.keysym.sym==SDLK_s) cam_py += 12;
                 if(e.key.keysym.sym==SDLK_F5){
-                    if(save_game(sim, "savegame.txt")){
-                        std::printf("[SAVE] OK -> savegame.txt\n");
-                        hud_show(hud, "Saved", 1500);
-                        if (sfxSave) Mix_PlayChannel(-1, sfxSave, 0);
+                    if(async_save_request(saver, sim, "savegame.sav", kSaveManual)){
+                        std::printf("[SAVE] tick %u -> savegame.sav (background)\n", sim.tick);
                     }else{
                         std::printf("[SAVE] FAILED\n");
                         hud_show(hud, "Save failed", 1500);
                     }
                 }
+                if(e.key.keysym.sym==SDLK_F11){
+                    if(!prof_enabled()) hud_show(hud, "Profiler off (RTS_PROFILE)", 1500);
+                    else if(prof_dump_chrome("trace.json")){
+                        std::printf("[PROF] trace -> trace.json\n");
+                        hud_show(hud, "Trace saved", 1500);
+                    }
+                }
                 if(e.key.keysym.sym==SDLK_F9){
-                    if(load_game(sim, "savegame.txt")){
-                        std::printf("[LOAD] OK <- savegame.txt\n");
+                    async_save_wait(saver); // rozpracovaný F5
+                    // savegame.txt = textový save starších verzí
+                    if(load_game(sim, "savegame.sav") || load_game(sim, "savegame.txt")){
+                        std::printf("[LOAD] OK\n");
+                        if(recording) std::printf("[REPLAY] recording stopped (state loaded)\n");
+                        recording = false;
                         hud_show(hud, "Loaded", 1500);
                         if (sfxLoad) Mix_PlayChannel(-1, sfxLoad, 0);
                     }else{
@@ -560,7 +599,7 @@ int main(int argc, char** argv){
 
                 BuildingId sbid = get_selected_building_id(sim);
                 if(e.key.keysym.sym==SDLK_DELETE && sbid){
-                    remove_building(sim, sbid, true);
+                    cmd(CmdType::RemoveBuilding, 0, 0, 0, sbid);
                 }
 
                 // Hotkeys
@@ -571,9 +610,9 @@ int main(int argc, char** argv){
                 }else if(sbid){
                     Building* b = find_building(sim, sbid);
                     if(b && b->kind==BuildingKind::Barracks && b->state==BuildState::Complete){
-                        if(e.key.keysym.sym==SDLK_q) queue_train(sim, *b, "footman", 1);
-                        if(e.key.keysym.sym==SDLK_w) queue_train(sim, *b, "footman", 5);
-                        if(e.key.keysym.sym==SDLK_e) cancel_last_train(sim, *b);
+                        if(e.key.keysym.sym==SDLK_q) train_cmd(*b, footman, 1);
+                        if(e.key.keysym.sym==SDLK_w) train_cmd(*b, footman, 5);
+                        if(e.key.keysym.sym==SDLK_e) cmd(CmdType::CancelLastTrain, 0, 0, 0, b->id);
                     }
                 }
             }
@@ -690,9 +729,9 @@ int main(int argc, char** argv){
                 if(sbid){
                     Building* b = find_building(sim, sbid);
                     if(b && b->kind==BuildingKind::Barracks && b->state==BuildState::Complete){
-                        if(rect_contains(cardBtns[0], e.button.x, e.button.y)) queue_train(sim, *b, "footman", 1);
-                        if(rect_contains(cardBtns[1], e.button.x, e.button.y)) queue_train(sim, *b, "footman", 5);
-                        if(rect_contains(cardBtns[2], e.button.x, e.button.y)) cancel_last_train(sim, *b);
+                        if(rect_contains(cardBtns[0], e.button.x, e.button.y)) train_cmd(*b, footman, 1);
+                        if(rect_contains(cardBtns[1], e.button.x, e.button.y)) train_cmd(*b, footman, 5);
+                        if(rect_contains(cardBtns[2], e.button.x, e.button.y)) cmd(CmdType::CancelLastTrain, 0, 0, 0, b->id);
                     }
                 }else if(any_workers_selected(sim)){
                     if(rect_contains(cardBtns[0], e.button.x, e.button.y)) bmode=BuildMode::Dropoff;
@@ -730,44 +769,19 @@ int main(int argc, char** argv){
                     int uy = int(my / g_zoom);
                     Vec2i t = screen_px_to_iso(ux, uy);
 
-                    auto bt = get_btype(
+                    const BuildingType& bt = get_btype(sim,
                         bmode==BuildMode::Dropoff ? BuildingKind::Dropoff :
                         bmode==BuildMode::Farm    ? BuildingKind::Farm    :
                                                     BuildingKind::Barracks
                     );
 
-                    if(can_place_building(sim, bt, t.x, t.y) &&
-                    (sim.gold >= bt.cost_gold && sim.wood >= bt.cost_wood))
+                    if(can_place_building(sim, bt, t.x, t.y) && can_afford(sim.players[LOCAL_PLAYER], bt))
                     {
-                        BuildingId bid = start_building(sim, bt, t.x, t.y);
+                        BuildingId bid = cmd(CmdType::PlaceBuilding, 0, t.x, t.y, (uint32_t)bt.kind);
                         if(bid){
                             // přiřaď vybrané dělníky k nové stavbě
-                            int ux2 = int(e.button.x / g_zoom);
-                            int uy2 = int(e.button.y / g_zoom);
-                            for(auto& u: sim.units){
-                                if(u.selected && u.type_index==0){
-                                    u.job = UnitJob::Building;
-                                    u.building_target = bid;
-
-                                    // najdi okrajové políčko kolem footprintu
-                                    Vec2i best = u.tile; int bestd=1e9; bool found=false;
-                                    for(int yy=t.y-1; yy<=t.y+bt.h; ++yy){
-                                        for(int xx=t.x-1; xx<=t.x+bt.w; ++xx){
-                                            bool onEdge = !(xx>=t.x && xx<t.x+bt.w && yy>=t.y && yy<t.y+bt.h);
-                                            if(onEdge && xx>=0 && yy>=0 && xx<sim.map.width && yy<sim.map.height){
-                                                if(!sim.map.blocked[idx(sim.map.width,xx,yy)] && sim.map.tiles[idx(sim.map.width,xx,yy)]!=1){
-                                                    int d = std::abs(xx-u.tile.x)+std::abs(yy-u.tile.y);
-                                                    if(d<bestd){ bestd=d; best={xx,yy}; found=true; }
-                                                }
-                                            }
-                                        }
-                                    }
-                                    if(found){
-                                        u.goal=best; u.path.clear();
-                                        astar_find(sim.map, u.tile, u.goal, u.path, true);
-                                    }
-                                }
-                            }
+                            for(auto& u: sim.units)
+                                if(u.selected && u.type_index==0) cmd(CmdType::Build, u.id, 0, 0, bid);
                         }
                         bmode = BuildMode::None;
                     }
@@ -778,7 +792,10 @@ int main(int argc, char** argv){
                         bool selectedSomething = false;
 
                         // units
-                        for(auto& u: sim.units){
+                        std::vector<uint32_t> near;
+                        units_near_screen_rect(sim, SDL_Rect{ux, uy, 1, 1}, near);
+                        for(uint32_t slot: near){
+                            auto& u = sim.units[slot];
                             SDL_Point p = iso_to_screen_px(u.tile.x, u.tile.y);
                             SDL_Rect ub = { p.x-UNIT_W/2, p.y-UNIT_H+ISO_H/2, UNIT_W, UNIT_H };
                             if(rect_contains(ub, ux, uy)){
@@ -806,7 +823,7 @@ int main(int argc, char** argv){
                         if(!selectedSomething){
                             Vec2i t = screen_px_to_iso(ux, uy);
                             if(t.x>=0 && t.y>=0 && t.x<sim.map.width && t.y<sim.map.height){
-                                int i = idx(sim.map.width, t.x, t.y);
+                                int i = ridx(sim.map, t.x, t.y);
                                 uint8_t rk = sim.map.res_kind[i]; // Wood/Gold?
                                 if(rk == (uint8_t)ResourceKind::Gold || rk == (uint8_t)ResourceKind::Wood){
                                     g_resPopup.tile_x = t.x;
@@ -834,7 +851,10 @@ int main(int argc, char** argv){
                         };
 
                         if(!(SDL_GetModState() & KMOD_SHIFT)) clear_selection(sim);
-                        for(auto& u: sim.units){
+                        std::vector<uint32_t> near;
+                        units_near_screen_rect(sim, rw, near);
+                        for(uint32_t slot: near){
+                            auto& u = sim.units[slot];
                             SDL_Point p = iso_to_screen_px(u.tile.x, u.tile.y);
                             SDL_Rect ub = { p.x-UNIT_W/2, p.y-UNIT_H+ISO_H/2, UNIT_W, UNIT_H };
                             SDL_Rect inter;
@@ -844,7 +864,6 @@ int main(int argc, char** argv){
                 }
             }
             if(e.type==SDL_MOUSEBUTTONUP && e.button.button==SDL_BUTTON_RIGHT){
-                relax_builders(sim);
                 // RMB: queue cancel click? (above cmd card)
                 bool queueHit=false;
                 BuildingId sbid = get_selected_building_id(sim);
@@ -854,7 +873,7 @@ int main(int argc, char** argv){
                         int qx = queuePanel.x+8; int qy=queuePanel.y+8;
                         for(size_t i=0;i<b->queue.size() && i<10;i++){
                             SDL_Rect box{ qx + int(i)*28, qy, 24, 24 };
-                            if(rect_contains(box, e.button.x, e.button.y)){ (void)cancel_train_at(sim, *b, i); queueHit=true; break; }
+                            if(rect_contains(box, e.button.x, e.button.y)){ cmd(CmdType::CancelTrainAt, 0, (int)i, 0, b->id); queueHit=true; break; }
                         }
                     }
                 }
@@ -869,7 +888,7 @@ int main(int argc, char** argv){
                             int ux = int(e.button.x / g_zoom);
                             int uy = int(e.button.y / g_zoom);
                             Vec2i t = screen_px_to_iso(ux, uy);
-                            bb->rally = t;
+                            cmd(CmdType::SetRally, 0, t.x, t.y, bb->id);
                             hud_show(hud, "Rally set", 900);
                             continue;
                         }
@@ -881,6 +900,26 @@ int main(int argc, char** argv){
                 int uy = int(e.button.y / g_zoom);
                 Vec2i t = screen_px_to_iso(ux, uy);
 
+                // RMB na cizí jednotku -> útok
+                {
+                    std::vector<uint32_t> near;
+                    units_near_screen_rect(sim, SDL_Rect{ux, uy, 1, 1}, near);
+                    UnitId enemy = 0;
+                    for(uint32_t slot: near){
+                        const auto& o = sim.units[slot];
+                        SDL_Point p = iso_to_screen_px(o.tile.x, o.tile.y);
+                        SDL_Rect ub = { p.x-UNIT_W/2, p.y-UNIT_H+ISO_H/2, UNIT_W, UNIT_H };
+                        if(o.owner!=LOCAL_PLAYER && fog_visible(sim.fog, LOCAL_PLAYER, o.tile.x, o.tile.y)
+                           && rect_contains(ub, ux, uy)){ enemy = o.id; break; }
+                    }
+                    if(enemy){
+                        std::vector<UnitId> attackers;
+                        for(const auto& u: sim.units) if(u.selected) attackers.push_back(u.id);
+                        for(UnitId id: attackers) cmd(CmdType::Attack, id, 0, 0, enemy);
+                        continue;
+                    }
+                }
+
                 // if clicking on building and it is not complete -> assign workers
                 Building* hit=nullptr;
                 for(auto& b: sim.buildings){
@@ -889,46 +928,54 @@ int main(int argc, char** argv){
                     if(rect_contains(sprite, ux, uy)) { hit = &b; break; }
                 }
                 if(hit && hit->state!=BuildState::Complete){
-                    for(auto& u: sim.units) if(u.selected && u.type_index==0){ u.job=UnitJob::Building; u.building_target=hit->id; }
+                    for(auto& u: sim.units) if(u.selected && u.type_index==0) cmd(CmdType::Build, u.id, 0, 0, hit->id);
                 }else{
                     for(auto& u: sim.units) if(u.selected){
                         uint8_t rk = (t.x>=0 && t.y>=0 && t.x<sim.map.width && t.y<sim.map.height)
-                        ? sim.map.res_kind[idx(sim.map.width,t.x,t.y)]
+                        ? sim.map.res_kind[ridx(sim.map, t.x,t.y)]
                         : (uint8_t)ResourceKind::None;
                         if(u.type_index==0 && (rk==(uint8_t)ResourceKind::Gold || rk==(uint8_t)ResourceKind::Wood))
-                            order_gather(sim,u.id,t.x,t.y);
+                            cmd(CmdType::Gather, u.id, t.x, t.y, 0);
                         else
-                            order_move(sim,u.id,t.x,t.y);
+                            cmd(CmdType::Move, u.id, t.x, t.y, 0);
                     }
                 }
             }
         }
 
         clamp_camera(sim);
+        RTS_PROF_END(events);
 
+        RTS_PROF_BEGIN(simloop, "frame.sim");
         uint64_t tnow = now_us(); acc += (double)(tnow-last)/1000000.0; last=tnow;
-        while(acc >= (1.0 / (double)sim.cfg.tick_rate)){ step(sim, (uint32_t)(1000.0 / (double)sim.cfg.tick_rate)); acc -= (1.0 / (double)sim.cfg.tick_rate); }
-        relax_builders(sim);
+        while(acc >= TICK){ step(sim, 1000u / (uint32_t)sim.cfg.tick_rate); acc -= TICK; }
+        RTS_PROF_END(simloop);
 
+        RTS_PROF_BEGIN(tiles, "frame.tiles");
         SDL_SetRenderDrawColor(ren, 10, 12, 16, 255); SDL_RenderClear(ren);
 
         SDL_RenderSetScale(ren, g_zoom, g_zoom); 
 
-        // Tiles
+        // Tiles (neprozkoumané se nekreslí, mimo dohled ztmavené)
         for(int y=0;y<sim.map.height;++y){
             for(int x=0;x<sim.map.width;++x){
+                if(!fog_explored(sim.fog, LOCAL_PLAYER, x, y)) continue;
+                bool vis = fog_visible(sim.fog, LOCAL_PLAYER, x, y);
                 SDL_Point c = iso_to_screen_px(x,y);
-                SDL_Rect src = src_for_tile(sim.map.tiles[idx(sim.map.width,x,y)], x, y);
+                SDL_Rect src = src_for_tile(sim.map.tiles[ridx(sim.map, x,y)], x, y);
                 SDL_Rect dst = { c.x - ISO_W/2, c.y - ISO_H/2, ISO_W, ISO_H };
+                if(!vis) SDL_SetTextureColorMod(texTiles, 110,110,120);
                 SDL_RenderCopy(ren, texTiles, &src, &dst);
+                if(!vis) SDL_SetTextureColorMod(texTiles, 255,255,255);
             }
         }
 
         // Resources (trees & gold) — draw after ground, before buildings
         for(int y=0; y<sim.map.height; ++y){
             for(int x=0; x<sim.map.width; ++x){
-                uint8_t rk = sim.map.res_kind[idx(sim.map.width,x,y)];
-                if(rk==(uint8_t)ResourceKind::Gold || rk==(uint8_t)ResourceKind::Wood){
+                uint8_t rk = sim.map.res_kind[ridx(sim.map, x,y)];
+                if((rk==(uint8_t)ResourceKind::Gold || rk==(uint8_t)ResourceKind::Wood)
+                   && fog_explored(sim.fog, LOCAL_PLAYER, x, y)){
                     SDL_Point c = iso_to_screen_px(x,y);
                     unsigned h = (unsigned)(x*73856093u) ^ (unsigned)(y*19349663u);
                     int variant = (int)(h & 7);
@@ -938,11 +985,12 @@ int main(int argc, char** argv){
                     SDL_Rect d = { c.x - 32, c.y - 56, 64, 64 };
 
                     // procento zbývající suroviny (uprav 300 dle tvého initu)
-                    int i = idx(sim.map.width,x,y);
+                    int i = ridx(sim.map, x,y);
                     int amt  = sim.map.res_amount[i];
                     int maxv = std::max(1, (int)sim.map.res_max[i]); // ochrana proti dělení nulou
                     float f  = std::clamp(amt / float(maxv), 0.2f, 1.0f); // 20–100 % jasu
                     Uint8 mod = (Uint8)(200 * f + 55);
+                    if(!fog_visible(sim.fog, LOCAL_PLAYER, x, y)) mod = (Uint8)(mod/2);
 
                     SDL_SetTextureColorMod(texRes, mod, mod, mod);
                     SDL_RenderCopy(ren, texRes, &s, &d);
@@ -951,6 +999,9 @@ int main(int argc, char** argv){
             }
         }
 
+        RTS_PROF_END(tiles);
+
+        RTS_PROF_BEGIN(units, "frame.units");
         // Buildings
         for(const auto& b: sim.buildings){
             SDL_Point c = iso_to_screen_px(b.tile.x, b.tile.y);
@@ -972,7 +1023,7 @@ int main(int argc, char** argv){
             // construction bar
             if(b.state!=BuildState::Complete){
                 int barw = 44;
-                float t = b.build_total_ms? (float)b.build_progress_ms/(float)b.build_total_ms : 0.f;
+                float t = b.build_total_ms? (float)building_progress_ms(sim,b)/(float)b.build_total_ms : 0.f;
                 if(t<0) t=0; if(t>1) t=1;
                 SDL_Rect bg{ dst.x+10, dst.y-12, barw, 6 };
                 SDL_Rect fg{ dst.x+10, dst.y-12, (int)(barw*t), 6 };
@@ -990,6 +1041,7 @@ int main(int argc, char** argv){
         SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
         for(int ui: ord){
             const auto& u = sim.units[ui];
+            if(u.owner!=LOCAL_PLAYER && !fog_visible(sim.fog, LOCAL_PLAYER, u.tile.x, u.tile.y)) continue;
             SDL_Point c = iso_to_screen_px(u.tile.x, u.tile.y);
             SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
             for(int r=0; r<4; ++r){
@@ -1036,7 +1088,7 @@ int main(int argc, char** argv){
             }
         }
         if (bmode!=BuildMode::None && hover.x>=0 && hover.y>=0) {
-            auto bt = get_btype(
+            const BuildingType& bt = get_btype(sim,
                 bmode==BuildMode::Dropoff ? BuildingKind::Dropoff :
                 bmode==BuildMode::Farm    ? BuildingKind::Farm    :
                                             BuildingKind::Barracks
@@ -1044,7 +1096,7 @@ int main(int argc, char** argv){
             Vec2i t = hover;
             bool ok = (t.x>=0 && t.y>=0 && t.x+bt.w<=sim.map.width && t.y+bt.h<=sim.map.height)
                     && can_place_building(sim, bt, t.x, t.y);
-            bool enough = (sim.gold >= bt.cost_gold && sim.wood >= bt.cost_wood);
+            bool enough = can_afford(sim.players[LOCAL_PLAYER], bt);
 
             {
                 const bool placeOk = ok && enough;
@@ -1107,7 +1159,7 @@ int main(int argc, char** argv){
             if(now > g_resPopup.until_ms){
                 g_resPopup.tile_x = -1;
             } else {
-                int i = idx(sim.map.width, g_resPopup.tile_x, g_resPopup.tile_y);
+                int i = ridx(sim.map, g_resPopup.tile_x, g_resPopup.tile_y);
                 int amt  = sim.map.res_amount[i];
                 int hasMax = !sim.map.res_max.empty();
                 int maxv = hasMax ? sim.map.res_max[i] : std::max(amt,1);
@@ -1174,8 +1226,11 @@ int main(int argc, char** argv){
         }
 
         SDL_RenderSetScale(ren, 1.0f, 1.0f);
+        RTS_PROF_END(units);
 
+        RTS_PROF_BEGIN(ui, "frame.ui");
         // ---------- UI LAYERS ----------
+        const Player& me = sim.players[LOCAL_PLAYER]; // ekonomika v HUD a na kartě příkazů
         SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
         for(int y=0; y<WINDOW_H; y+=4){
             Uint8 a = (Uint8)std::min(60 + (y * 80 / WINDOW_H), 120); // 60..120
@@ -1201,15 +1256,15 @@ int main(int argc, char** argv){
 
             SDL_Color txt{235,235,240,255};
             if(font){
-                draw_text(ren, font, std::to_string(sim.gold).c_str(), icG.x+28, 22, txt);
-                draw_text(ren, font, std::to_string(sim.wood).c_str(), icW.x+28, 22, txt);
-                char foodBuf[32]; std::snprintf(foodBuf, sizeof(foodBuf), "%d/%d", sim.food_used, sim.food_cap);
+                draw_text(ren, font, std::to_string(me.gold).c_str(), icG.x+28, 22, txt);
+                draw_text(ren, font, std::to_string(me.wood).c_str(), icW.x+28, 22, txt);
+                char foodBuf[32]; std::snprintf(foodBuf, sizeof(foodBuf), "%d/%d", me.food_used, me.food_cap);
                 draw_text(ren, font, foodBuf, icF.x+28, 22, txt);
             }
 
             // supply bar (ala WC)
             SDL_Rect supBg{ 320, 22, 170, 16 };
-            float t = (sim.food_cap>0) ? (float)sim.food_used/(float)sim.food_cap : 0.f;
+            float t = (me.food_cap>0) ? (float)me.food_used/(float)me.food_cap : 0.f;
             fill_bar(ren, supBg, t, SDL_Color{40,44,54,255}, SDL_Color{100,200,120,255});
             bevel_box(ren, supBg, SDL_Color{0,0,0,0}, SDL_Color{60,80,110,255}, SDL_Color{120,150,190,180}, 255);
         }
@@ -1241,7 +1296,7 @@ int main(int argc, char** argv){
                     // progress bar stavby (bevel + výplň)
                     if (b->state != BuildState::Complete){
                         SDL_Rect pbg{ box.x+12, box.y+68, 96, 6 };
-                        float rt = b->build_total_ms ? (float)b->build_progress_ms / (float)b->build_total_ms : 0.f;
+                        float rt = b->build_total_ms ? (float)building_progress_ms(sim,*b) / (float)b->build_total_ms : 0.f;
                         fill_bar(ren, pbg, rt, SDL_Color{40,44,54,255}, SDL_Color{100,200,120,255});
                         bevel_box(ren, pbg, SDL_Color{0,0,0,0}, SDL_Color{60,80,110,255}, SDL_Color{120,150,190,160}, 255);
                     }
@@ -1281,13 +1336,13 @@ int main(int argc, char** argv){
 
             if(workersSel){
                 // affordability
-                bool canDrop  = (sim.gold >= 120);
-                bool canFarm  = (sim.gold >= 60 && sim.wood >= 40);
-                bool canBarr  = (sim.gold >= 150 && sim.wood >= 80);
+                const BuildingType& btDrop = get_btype(sim, BuildingKind::Dropoff);
+                const BuildingType& btFarm = get_btype(sim, BuildingKind::Farm);
+                const BuildingType& btBarr = get_btype(sim, BuildingKind::Barracks);
 
-                Btn b0{cardBtns[0], 2, canDrop, "Drop-off", "1", 120, 0};
-                Btn b1{cardBtns[1], 3, canFarm, "Farm",     "2", 60, 40};
-                Btn b2{cardBtns[2], 4, canBarr, "Barracks", "3", 150, 80};
+                Btn b0{cardBtns[0], 2, can_afford(me, btDrop), "Drop-off", "1", btDrop.cost_gold, btDrop.cost_wood};
+                Btn b1{cardBtns[1], 3, can_afford(me, btFarm), "Farm",     "2", btFarm.cost_gold, btFarm.cost_wood};
+                Btn b2{cardBtns[2], 4, can_afford(me, btBarr), "Barracks", "3", btBarr.cost_gold, btBarr.cost_wood};
 
                 draw_cc_btn(ren, texIcons, b0);
                 draw_cc_btn(ren, texIcons, b1);
@@ -1317,8 +1372,9 @@ int main(int argc, char** argv){
             } else if(sbid){
                 const Building* b = find_building(sim, sbid);
                 if(b && b->kind==BuildingKind::Barracks && b->state==BuildState::Complete){
-                    bool canFoot = (sim.gold >= 100 && sim.food_used+1 <= sim.food_cap);
-                    Btn bf{cardBtns[0], 5, canFoot, "Footman", "Q", 100, 0};
+                    const UnitType* ut = footman!=kNoUnitType ? &sim.unit_types[footman] : nullptr;
+                    bool canFoot = ut && me.gold >= ut->cost_gold && me.wood >= ut->cost_wood && me.food_used+ut->food <= me.food_cap;
+                    Btn bf{cardBtns[0], 5, canFoot, "Footman", "Q", ut ? ut->cost_gold : 0, ut ? ut->cost_wood : 0};
                     Btn bp{cardBtns[1], 7, true,    "x5",      "W", 0, 0};
                     Btn bc{cardBtns[2], 6, true,    "Cancel",  "E", 0, 0};
                     draw_cc_btn(ren, texIcons, bf);
@@ -1497,13 +1553,17 @@ int main(int argc, char** argv){
             }
         }
 
+        RTS_PROF_END(ui);
+
+        RTS_PROF_BEGIN(minimap, "frame.minimap");
         // Minimap
         {
             SDL_Rect mm_bg{mm_x-2, mm_y-2, mm_w+4, mm_h+4};
             SDL_SetRenderDrawColor(ren, 8, 8, 12, 220); SDL_RenderFillRect(ren, &mm_bg);
             for(int y=0;y<sim.map.height;++y){
                 for(int x=0;x<sim.map.width;++x){
-                    uint8_t t = sim.map.tiles[idx(sim.map.width,x,y)];
+                    if(!fog_explored(sim.fog, LOCAL_PLAYER, x, y)) continue;
+                    uint8_t t = sim.map.tiles[ridx(sim.map, x,y)];
                     Uint8 r=40,g=90,b=40;          // grass
                     if(t==1){ r=90; g=90; b=110; } // rock
                     else if(t==2){ r=190; g=160; b=55; } // sand
@@ -1526,6 +1586,7 @@ int main(int argc, char** argv){
                 SDL_RenderDrawPoint(ren,px,py+1);
             }
             for(const auto& u: sim.units){
+                if(u.owner!=LOCAL_PLAYER && !fog_visible(sim.fog, LOCAL_PLAYER, u.tile.x, u.tile.y)) continue;
                 int px = mm_x + u.tile.x*mm_w/sim.map.width;
                 int py = mm_y + u.tile.y*mm_h/sim.map.height;
                 if(u.selected) SDL_SetRenderDrawColor(ren,255,255,255,255);
@@ -1540,15 +1601,24 @@ int main(int argc, char** argv){
         {
             uint32_t now = SDL_GetTicks();
             if (now >= next_autosave_ms) {
-                if (save_game(sim, "autosave.txt")) {
-                    std::printf("[AUTOSAVE] -> autosave.txt\n");
-                    hud_show(hud, "Autosaved", 1200);
-                } else {
+                if (!async_save_request(saver, sim, "autosave.sav", kSaveAuto, true)) {
                     std::printf("[AUTOSAVE] FAILED\n");
                     hud_show(hud, "Autosave failed", 1200);
                 }
                 next_autosave_ms = now + autosave_period_ms;
             }
+            SaveResult sr;
+            while (async_save_poll(saver, sr)) {
+                const bool manual = sr.tag == kSaveManual;
+                if (sr.ok) {
+                    std::printf("[%s] OK -> %s (%.1f ms)\n", manual ? "SAVE" : "AUTOSAVE", sr.path.c_str(), sr.ms);
+                    hud_show(hud, manual ? "Saved" : "Autosaved", manual ? 1500 : 1200);
+                    if (manual && sfxSave) Mix_PlayChannel(-1, sfxSave, 0);
+                } else {
+                    std::printf("[%s] FAILED -> %s\n", manual ? "SAVE" : "AUTOSAVE", sr.path.c_str());
+                    hud_show(hud, manual ? "Save failed" : "Autosave failed", 1500);
+                }
+            }
         }
 
         {
@@ -1564,11 +1634,18 @@ int main(int argc, char** argv){
             }
         }
 
+        RTS_PROF_END(minimap);
+
+        RTS_PROF_BEGIN(present, "frame.present");
         SDL_RenderPresent(ren);
+        RTS_PROF_END(present);
 
         SDL_Delay(1);
     }
 
+    async_save_wait(saver); // autosave z SDL_QUIT
+    if(prof_enabled() && prof_dump_chrome("trace.json")) std::printf("[PROF] trace -> trace.json\n");
+
     SDL_DestroyTexture(texTiles); SDL_DestroyTexture(texUnits); SDL_DestroyTexture(texEdges); SDL_DestroyTexture(texBuild); SDL_DestroyTexture(texIcons); SDL_DestroyTexture(texRes); 
 
     if (font) TTF_CloseFont(font);
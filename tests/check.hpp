@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdio>
+
+// Minimální aserce testů: selhání se vypíše a počítá, main vrátí check_report().
+inline int check_failures = 0;
+#define CHECK(c) do{ if(!(c)){ std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); ++check_failures; } }while(0)
+
+inline int check_report(const char* name){
+    if(check_failures) std::fprintf(stderr, "%s: %d check(s) failed\n", name, check_failures);
+    else std::printf("%s: OK\n", name);
+    return check_failures ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+# Determinismus napříč buildy: rts_headless sestavený s -O0 a s -O3 -ffast-math
+# musí po stejném scénáři vypsat stejný state_hash (--hash).
+# Výchozí scénář kromě těžby a boje staví (víc stavitelů = rychlost stavby v fx) a cvičí.
+#   cmake -DSRC=<zdroje> -DOUT=<pracovní adresář> [-DARGS="--gen;256;256;--ticks;600;--seed;3"] -P determinism.cmake
+if(NOT SRC OR NOT OUT)
+    message(FATAL_ERROR "usage: cmake -DSRC=... -DOUT=... -P determinism.cmake")
+endif()
+if(NOT ARGS)
+    set(ARGS --gen 256 256 --ticks 600 --seed 3 --players 2 --builders 4)
+endif()
+
+set(configs "O0|-O0" "fast|-O3 -ffast-math")
+set(hashes "")
+foreach(cfg IN LISTS configs)
+    string(REPLACE "|" ";" cfg "${cfg}")
+    list(GET cfg 0 name)
+    list(GET cfg 1 flags)
+    set(dir "${OUT}/${name}")
+    execute_process(COMMAND ${CMAKE_COMMAND} -S ${SRC} -B ${dir} -DCMAKE_BUILD_TYPE= "-DCMAKE_CXX_FLAGS=${flags}" -DRTS_TESTS=OFF
+                    RESULT_VARIABLE rc OUTPUT_QUIET)
+    if(rc)
+        message(FATAL_ERROR "${name}: configure failed")
+    endif()
+    execute_process(COMMAND ${CMAKE_COMMAND} --build ${dir} --target rts_headless -j 4 RESULT_VARIABLE rc OUTPUT_QUIET)
+    if(rc)
+        message(FATAL_ERROR "${name}: build failed")
+    endif()
+    set(exe "")
+    foreach(c ${dir}/rts_headless ${dir}/rts_headless.exe ${dir}/Debug/rts_headless.exe)
+        if(NOT exe AND EXISTS ${c})
+            set(exe ${c})
+        endif()
+    endforeach()
+    execute_process(COMMAND ${exe} --assets ${SRC}/assets ${ARGS} --hash
+                    RESULT_VARIABLE rc OUTPUT_VARIABLE out OUTPUT_STRIP_TRAILING_WHITESPACE)
+    if(rc)
+        message(FATAL_ERROR "${name}: rts_headless failed (${rc})")
+    endif()
+    message(STATUS "${name} (${flags}): ${out}")
+    list(APPEND hashes "${out}")
+endforeach()
+
+list(GET hashes 0 a)
+list(GET hashes 1 b)
+if(NOT a STREQUAL b)
+    message(FATAL_ERROR "state hash differs between builds: ${a} vs ${b}")
+endif()
@@ -0,0 +1,55 @@
+// Hodnoty fx.hpp: saturace, fx_sqrt (celočíselná odmocnina), tabulkový sin/cos.
+#include "fx.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+int main(){
+    // převody a zaokrouhlení
+    CHECK(fx_from_int(3).v == 3*65536);
+    CHECK(fx_ratio(3,4).v == 49152);
+    CHECK(fx_floor_to_int(fx{-1}) == -1);
+    CHECK(fx_round_to_int(fx{0x8000}) == 1 && fx_round_to_int(fx{0x7FFF}) == 0);
+    CHECK(fx_mul_int_floor(fx_ratio(7,4), 50) == 87);
+    CHECK(fx_mul_int_floor(fx_from_int(30000), 1000) == 30000000); // mimo rozsah Q16, ale v int
+
+    // saturace
+    const fx big{INT32_MAX}, small{INT32_MIN};
+    CHECK(fx_add_sat(big, fx{1}).v == INT32_MAX);
+    CHECK(fx_sub_sat(small, fx{1}).v == INT32_MIN);
+    CHECK(fx_add_sat(fx_from_int(2), fx_from_int(3)) == fx_from_int(5));
+    CHECK(fx_mul_sat(big, big).v == INT32_MAX);
+    CHECK(fx_mul_sat(small, big).v == INT32_MIN);
+    CHECK(fx_mul_sat(fx_from_int(-3), fx_ratio(1,2)) == fx_ratio(-3,2));
+    CHECK(fx_div_sat(fx_from_int(1), fx{0}).v == INT32_MAX);
+    CHECK(fx_div_sat(fx_from_int(-1), fx{0}).v == INT32_MIN);
+    CHECK(fx_div_sat(fx_from_int(1), fx_from_int(4)) == fx_ratio(1,4));
+    CHECK(fx_div_sat(big, fx{1}).v == INT32_MAX);
+
+    // fx_sqrt: r = floor(sqrt(v * 2^16)), tj. r^2 <= v<<16 < (r+1)^2
+    CHECK(fx_sqrt(fx{0}).v == 0 && fx_sqrt(fx_from_int(-4)).v == 0);
+    CHECK(fx_sqrt(fx_from_int(4)) == fx_from_int(2));
+    CHECK(fx_sqrt(fx_from_int(2)).v == 92681);
+    for(int64_t v = 1; v <= INT32_MAX; v += 1 + v/1024){
+        const int64_t r = fx_sqrt(fx{(int32_t)v}).v, x = v << 16;
+        if(!(r*r <= x && (r+1)*(r+1) > x)){ CHECK(!"fx_sqrt floor"); std::fprintf(stderr, "  v=%lld r=%lld\n", (long long)v, (long long)r); break; }
+    }
+    CHECK(fx_sqrt(big).v == 11863283);
+
+    // sin/cos: přesné hodnoty v násobcích 90°, symetrie, chyba proti std::sin
+    CHECK(fx_sin(0).v == 0 && fx_sin(16384).v == 65536 && fx_sin(32768).v == 0 && fx_sin(49152).v == -65536);
+    CHECK(fx_cos(0).v == 65536 && fx_cos(32768).v == -65536);
+    int max_err = 0; bool odd = true;
+    for(uint32_t a = 0; a < 65536; ++a){
+        const int32_t s = fx_sin((uint16_t)a).v;
+        odd = odd && (a == 0 || s == -fx_sin((uint16_t)(65536 - a)).v);
+        const int32_t ref = (int32_t)std::lround(std::sin(a * (2.0 * 3.14159265358979323846 / 65536.0)) * 65536.0);
+        max_err = std::max(max_err, std::abs(s - ref));
+    }
+    CHECK(odd);
+    CHECK(max_err <= 4);
+    std::printf("sin max error %d/65536\n", max_err);
+    return check_report("fx_test");
+}
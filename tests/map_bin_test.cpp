@@ -0,0 +1,41 @@
+// map.txt -> .rtsmap -> zpět: dlaždice, sklady a zásoby sedí; mapa zkompilovaná
+// z jiného zdroje (jiná velikost, nebo jiný čas i CRC) se odmítne.
+//   rts_test_map_bin ASSETS     (map_bin_test.rtsmap v aktuálním adresáři)
+#include "sim.hpp"
+#include "data.hpp"
+#include "check.hpp"
+#include <string>
+
+int main(int argc, char** argv){
+    if(argc<2){ std::fprintf(stderr, "usage: rts_test_map_bin ASSETS\n"); return 2; }
+    const std::string txt = std::string(argv[1]) + "/map.txt", bin = "map_bin_test.rtsmap";
+    Map m; MapSource src;
+    CHECK(load_map_txt(txt, m));
+    CHECK(map_source_of(txt, &src) && src.size>0);
+    CHECK(save_map_bin(m, bin, 300, 500, src));
+
+    Map b; std::vector<Vec2i> drops;
+    CHECK(load_map_bin(bin, b, drops, &txt));
+    CHECK(b.width==m.width && b.height==m.height && b.tiles==m.tiles);
+    size_t n_drops = 0;
+    for(int i=0;i<m.width*m.height;++i){
+        const uint8_t t = m.tiles[i];
+        n_drops += t==4;
+        const int want = t==3 ? 300 : t==2 ? 500 : 0;
+        if(b.res_amount[i]!=want || b.res_max[i]!=want || b.blocked[i]){ CHECK(!"resource layers"); break; }
+    }
+    CHECK(n_drops>0 && drops.size()==n_drops);
+    for(auto d: drops) CHECK(m.tiles[(size_t)d.y*m.width + d.x]==4);
+
+    // zastaralá mapa (map.txt se od kompilace změnil) a mapa bez kontroly zdroje
+    Map c; std::vector<Vec2i> cd;
+    MapSource other = src; other.size += 1;
+    CHECK(save_map_bin(m, bin, 300, 500, other) && !load_map_bin(bin, c, cd, &txt));
+    other = src; other.mtime -= 1; // jen jiný čas (checkout): rozhodne CRC
+    CHECK(save_map_bin(m, bin, 300, 500, other) && load_map_bin(bin, c, cd, &txt));
+    other.crc ^= 1;
+    CHECK(save_map_bin(m, bin, 300, 500, other) && !load_map_bin(bin, c, cd, &txt));
+    CHECK(load_map_bin(bin, c, cd) && c.tiles==m.tiles);
+    CHECK(!load_map_bin(txt, c, cd)); // map.txt není .rtsmap
+    return check_report("map_bin");
+}
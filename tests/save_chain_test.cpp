@@ -0,0 +1,70 @@
+// Autosave jako keyframe + delta: load po každém savu dá stejný otisk, nezměněné
+// jednotky delta nepřepisuje a nový SaveChain nepřepíše keyframe ležící delty.
+//   rts_test_save_chain ASSETS     (save_chain_test.* v aktuálním adresáři)
+#include "sim.hpp"
+#include "savegame.hpp"
+#include "state_hash.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static const std::string kPath = "save_chain_test.sav";
+
+static size_t file_size(const std::string& path){
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return f ? (size_t)f.tellg() : 0;
+}
+
+static void run(Sim& s, int ticks){ for(int i=0;i<ticks;++i) step(s, 1000 / s.cfg.tick_rate); }
+
+static bool load_matches(const std::string& assets, const std::string& path, const Sim& s){
+    Sim l;
+    if(!load_data(l, assets) || !load_game(l, path)) return false;
+    if(l.tick!=s.tick || state_hash(l)!=state_hash(s) || state_hash_full(l)!=state_hash(s)) return false;
+    if(l.units.size()!=s.units.size() || l.buildings.size()!=s.buildings.size()) return false;
+    for(size_t i=0;i<s.units.size();++i) if(l.units[i].id!=s.units[i].id) return false; // pořadí jednotek
+    return true;
+}
+
+int main(int argc, char** argv){
+    if(argc<2){ std::fprintf(stderr, "usage: rts_test_save_chain ASSETS\n"); return 2; }
+    const std::string assets = argv[1];
+    for(const char* suffix: { "", ".k0", ".k1" }) std::remove((kPath + suffix).c_str());
+
+    // 60 stojících vojáků, pár dělníků v lese a farma ve stavbě; hráč 1 (PLYR) jen stojí opodál
+    Sim s;
+    CHECK(load_data(s, assets) && set_player_count(s, 2));
+    if(s.map.res_kind.empty()) init_resources_from_tiles(s, 300, 500);
+    for(int i=0;i<60;++i) spawn_unit(s, "footman", 1 + i%20, 10 + i/20);
+    for(int i=0;i<3;++i) spawn_unit(s, "footman", s.map.width - 2 - i, s.map.height - 2, 1);
+    for(int i=0;i<4;++i) order_gather(s, spawn_unit(s, "footman", 2 + i, 5), 5, 4);
+    s.players[0].wood += 100;
+    const BuildingId farm = start_building(s, get_btype(s, BuildingKind::Farm), 17, 7);
+    CHECK(farm!=0);
+    order_build(s, s.units.back().id, farm);
+
+    SaveChain c; c.keyframe_every = 3;
+    for(int k=0;k<7;++k){
+        run(s, 40);
+        size_t chunks = 0;
+        CHECK(save_game_chain(s, c, kPath, &chunks));
+        CHECK(load_matches(assets, kPath, s));
+        // záznam nezměněné jednotky stojí 5 B místo celých 43 B
+        if(c.deltas==1) CHECK(file_size(kPath) < 1024 + 10*s.units.size());
+    }
+    CHECK(s.units.size() > 60 && c.key.file.size() > kPath.size());
+
+    // nový běh (prázdný SaveChain): první keyframe jde do druhého slotu, takže
+    // dosavadní delta zůstane načitatelná, kdyby zápis nové delty nedoběhl
+    const std::string slot = c.key.file, prev = "save_chain_test_prev.sav";
+    { std::ifstream in(kPath, std::ios::binary); std::ofstream out(prev, std::ios::binary); out << in.rdbuf(); }
+    CHECK(load_matches(assets, prev, s));
+    run(s, 20);
+    SaveChain c2;
+    CHECK(save_game_chain(s, c2, kPath));
+    CHECK(c2.key.file!=slot);
+    CHECK(load_matches(assets, kPath, s));
+    { Sim l; CHECK(load_data(l, assets) && load_game(l, prev)); }
+    return check_report("save_chain");
+}
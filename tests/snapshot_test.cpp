@@ -0,0 +1,72 @@
+// Snapshot: obnova dá stejný otisk i pokračování, kopie snapshotu sdílí
+// nezměněné bloky mapy a zápis do jiného snapshotu je nezmění (copy-on-write).
+//   rts_test_snapshot ASSETS
+#include "sim.hpp"
+#include "snapshot.hpp"
+#include "state_hash.hpp"
+#include "mapgen.hpp"
+#include "data.hpp"
+#include "check.hpp"
+#include <cstdlib>
+#include <string>
+
+static uint64_t chunks_sum(const SimSnapshot& snap){
+    uint64_t h = 0;
+    for(const auto& c: snap.chunks){
+        for(int v: c->res_amount) h = hash_mix(h ^ (uint32_t)v);
+        for(uint8_t t: c->tiles) h = hash_mix(h ^ t);
+    }
+    return h;
+}
+
+static void run(Sim& s, int ticks){ for(int i=0;i<ticks;++i) step(s, 1000 / s.cfg.tick_rate); }
+
+int main(int argc, char** argv){
+    if(argc<2){ std::fprintf(stderr, "usage: rts_test_snapshot ASSETS\n"); return 2; }
+    Sim s;
+    CHECK(load_units_csv(std::string(argv[1]) + "/units.csv", s.unit_types, s.unit_type_index));
+    MapGenParams p; p.width = 128; p.height = 128; p.seed = 11; // 4x4 bloky
+    CHECK(mapgen_generate(s, p));
+    init_resources_from_tiles(s, 300, 500);
+    const Vec2i d = s.players[0].dropoffs.empty() ? Vec2i{64,64} : s.players[0].dropoffs[0];
+    Vec2i wood{-1,-1}; int best = 1<<30;
+    for(int y=0;y<s.map.height;++y) for(int x=0;x<s.map.width;++x){
+        int dd = std::abs(x-d.x) + std::abs(y-d.y);
+        if(s.map.tiles[(size_t)y*s.map.width + x]==3 && dd<best){ best = dd; wood = {x,y}; }
+    }
+    for(int i=0;i<8;++i){
+        UnitId u = spawn_unit(s, "footman", d.x + 1 + i%4, d.y + 1 + i/4);
+        order_gather(s, u, wood.x, wood.y);
+    }
+    run(s, 20);
+
+    SimSnapshot snap;
+    CHECK(snapshot_take(s, snap));
+    const uint64_t h0 = state_hash(s);
+    SimSnapshot copy = snap;
+    bool all_shared = true;
+    for(size_t c=0;c<snap.chunks.size();++c) all_shared &= copy.chunks[c]==snap.chunks[c];
+    CHECK(snap.chunks.size()==16 && all_shared);
+    const uint64_t copy_sum = chunks_sum(copy);
+
+    run(s, 300); // těžba mění zásoby v bloku u lesa
+    const uint64_t h1 = state_hash(s);
+    CHECK(h1!=h0);
+    CHECK(snapshot_take(s, snap));
+    int shared = 0, replaced = 0;
+    for(size_t c=0;c<snap.chunks.size();++c){
+        if(snap.chunks[c]==copy.chunks[c]){ ++shared; CHECK(snap.chunk_ver[c]==copy.chunk_ver[c]); }
+        else ++replaced;
+    }
+    CHECK(shared>0 && replaced>0);
+    CHECK(chunks_sum(copy)==copy_sum); // sdílené bloky se nepřepsaly na místě
+
+    // návrat do stavu kopie a znovu stejný vývoj
+    CHECK(snapshot_restore(s, copy));
+    CHECK(state_hash(s)==h0 && state_hash_full(s)==h0);
+    run(s, 300);
+    CHECK(state_hash(s)==h1 && state_hash_full(s)==h1);
+    CHECK(snapshot_restore(s, snap));
+    CHECK(state_hash(s)==h1 && state_hash_full(s)==h1);
+    return check_report("snapshot");
+}